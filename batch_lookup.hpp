@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+template<typename...>
+struct make_void {
+    using type = void;
+};
+
+// How batch_contains() steps through one lookup in a map.  Maps without a
+// stepping interface run the whole find() as a single step, so they work in
+// a batch but gain nothing from it.
+template<typename Map, typename = void>
+struct LookupSteps {
+    using key_type = typename Map::key_type;
+
+    struct state {
+        bool found;
+    };
+
+    static void begin(Map const&, state&, key_type const&) {}
+
+    static bool step(Map const& map, state& s, key_type const& key) {
+        s.found = map.find(key) != map.end();
+        return true;
+    }
+
+    static bool found(Map const&, state const& s, key_type const&) {
+        return s.found;
+    }
+};
+
+// Maps with find_begin(), find_step() and find_end(), like the skiplists.
+template<typename Map>
+struct LookupSteps<Map, typename make_void<typename Map::find_state>::type> {
+    using key_type = typename Map::key_type;
+    using state = typename Map::find_state;
+
+    static void begin(Map const& map, state& s, key_type const& key) {
+        map.find_begin(s, key);
+    }
+
+    static bool step(Map const& map, state& s, key_type const& key) {
+        return map.find_step(s, key);
+    }
+
+    static bool found(Map const& map, state const& s, key_type const& key) {
+        return map.find_end(s, key) != map.end();
+    }
+};
+
+// Looks up the keys in [begin, end) with up to `group` lookups in flight,
+// stepping each in turn so their cache misses overlap (asynchronous memory
+// access chaining).  A lookup that finishes hands its slot to the next key.
+// Writes whether each key was found to out[0], out[1], ... in input order.
+template<typename Map, typename KeyIter, typename OutIter>
+void batch_contains(Map const& map, KeyIter begin, KeyIter end, OutIter out, std::size_t group) {
+    using Steps = LookupSteps<Map>;
+    struct Slot {
+        typename Steps::state state;
+        KeyIter key;
+        bool active;
+    };
+
+    std::vector<Slot> slots(group == 0 ? 1 : group);
+    KeyIter next = begin;
+    std::size_t active = 0;
+    for (auto& slot : slots) {
+        slot.active = next != end;
+        if (!slot.active)
+            continue;
+        slot.key = next++;
+        Steps::begin(map, slot.state, *slot.key);
+        ++active;
+    }
+
+    while (active > 0) {
+        for (auto& slot : slots) {
+            if (!slot.active || !Steps::step(map, slot.state, *slot.key))
+                continue;
+            out[slot.key - begin] = Steps::found(map, slot.state, *slot.key);
+            if (next == end) {
+                slot.active = false;
+                --active;
+                continue;
+            }
+            slot.key = next++;
+            Steps::begin(map, slot.state, *slot.key);
+        }
+    }
+}
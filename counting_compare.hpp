@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Calls made to the comparators below since the last reset.
+inline std::size_t& comparison_count() {
+    static std::size_t count = 0;
+    return count;
+}
+
+// std::less hidden behind a type the skiplists don't know, so searches
+// fall back to two-way comparisons.
+template<typename T>
+struct TwoWayLess {
+    bool operator()(T const& a, T const& b) const {
+        return std::less<T>{}(a, b);
+    }
+};
+
+// Counts every call.  Searches ask it one yes/no question at a time.
+template<typename T>
+struct CountingLess {
+    bool operator()(T const& a, T const& b) const {
+        ++comparison_count();
+        return a < b;
+    }
+};
+
+// Counts every call too, but also answers compare(), so searches use one
+// three-way comparison per node.
+template<typename T>
+struct CountingCompare : CountingLess<T> {
+    int compare(T const& a, T const& b) const {
+        ++comparison_count();
+        return a.compare(b);
+    }
+};
@@ -14,5 +14,260 @@ std::ostream& operator<<(std::ostream& os, Result const& result) {
     print_aligned(result.query_time.count(), os);
     os << ',';
     print_aligned(result.memory_usage, os);
+    os << ',';
+    print_aligned(result.stats.level_histogram, os);
+    os << ',';
+    print_aligned(result.stats.average_path, os);
+    os << ',';
+    print_aligned(result.stats.max_path, os);
+    os << ',';
+    print_aligned(result.stats.node_bytes, os);
+    os << ',';
+    print_aligned(result.stats.pointer_bytes, os);
+    os << ',';
+    print_aligned(result.stats.sentinel_bytes, os);
+    os << ',';
+    print_aligned(result.stats.update_bytes, os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, FilterResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.target_rate, os);
+    os << ',';
+    print_aligned(result.false_positive_rate, os);
+    os << ',';
+    print_aligned(result.filter_memory, os);
+    os << ',';
+    print_aligned(result.miss_time.count(), os);
+    os << ',';
+    print_aligned(result.filtered_miss_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, ScanResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.threads, os);
+    os << ',';
+    print_aligned(result.scan_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, BuildResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.threads, os);
+    os << ',';
+    print_aligned(result.insertion_time.count(), os);
+    os << ',';
+    print_aligned(result.build_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, LazyResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.erase_time.count(), os);
+    os << ',';
+    print_aligned(result.lazy_erase_time.count(), os);
+    os << ',';
+    print_aligned(result.compact_time.count(), os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.tombstone_query_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, TuneResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.probability, os);
+    os << ',';
+    print_aligned(result.max_level, os);
+    os << ',';
+    print_aligned(result.insertion_time.count(), os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.memory_usage, os);
+    os << ',';
+    print_aligned(result.pareto ? "yes" : "no", os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, ZipfResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.skew, os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.adaptive_query_time.count(), os);
+    os << ',';
+    print_aligned(result.adapt_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, ThroughputResult const& result) {
+    print_aligned(result.structure, os);
+    os << ',';
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.threads, os);
+    os << ',';
+    print_aligned(result.op_time.count(), os);
+    os << ',';
+    print_aligned(result.batch_op_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, CacheResult const& result) {
+    print_aligned(result.structure, os);
+    os << ',';
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.skew, os);
+    os << ',';
+    print_aligned(result.hit_ratio, os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.cached_query_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, SmallResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.memory_usage, os);
+    os << ',';
+    print_aligned(result.small_memory_usage, os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.small_query_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, PagedResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.leaf_pages, os);
+    os << ',';
+    print_aligned(result.pool_pages, os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.paged_query_time.count(), os);
+    os << ',';
+    print_aligned(result.reads_per_query, os);
+    os << ',';
+    print_aligned(result.scan_time.count(), os);
+    os << ',';
+    print_aligned(result.paged_scan_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, BatchResult const& result) {
+    print_aligned(result.structure, os);
+    os << ',';
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.group, os);
+    os << ',';
+    print_aligned(result.query_time.count(), os);
+    os << ',';
+    print_aligned(result.batch_query_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, LatencyResult const& result) {
+    print_aligned(result.structure, os);
+    os << ',';
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.insert_p50.count(), os);
+    os << ',';
+    print_aligned(result.insert_p99.count(), os);
+    os << ',';
+    print_aligned(result.insert_p999.count(), os);
+    os << ',';
+    print_aligned(result.query_p50.count(), os);
+    os << ',';
+    print_aligned(result.query_p99.count(), os);
+    os << ',';
+    print_aligned(result.query_p999.count(), os);
+    os << ',';
+    print_aligned(result.erase_p50.count(), os);
+    os << ',';
+    print_aligned(result.erase_p99.count(), os);
+    os << ',';
+    print_aligned(result.erase_p999.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, CompareResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.two_way_comparisons, os);
+    os << ',';
+    print_aligned(result.three_way_comparisons, os);
+    os << ',';
+    print_aligned(result.two_way_query_time.count(), os);
+    os << ',';
+    print_aligned(result.three_way_query_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, MergeResult const& result) {
+    print_aligned(result.key_type, os);
+    os << ',';
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.batch, os);
+    os << ',';
+    print_aligned(result.insertion_time.count(), os);
+    os << ',';
+    print_aligned(result.merge_time.count(), os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, PrefixResult const& result) {
+    print_aligned(result.elements, os);
+    os << ',';
+    print_aligned(result.prefixes, os);
+    os << ',';
+    print_aligned(result.erase_if_time.count(), os);
+    os << ',';
+    print_aligned(result.erase_prefix_time.count(), os);
     return os;
 }
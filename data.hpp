@@ -5,6 +5,17 @@
 #include <string>
 #include <iosfwd>
 
+// Shape of a structure that can describe itself; left empty for the others.
+struct StructureStats {
+    std::string level_histogram;
+    double average_path = 0;
+    std::size_t max_path = 0;
+    std::size_t node_bytes = 0;
+    std::size_t pointer_bytes = 0;
+    std::size_t sentinel_bytes = 0;
+    std::size_t update_bytes = 0;
+};
+
 struct Result {
     std::string structure;
     std::string key_type;
@@ -12,6 +23,184 @@ struct Result {
     time_unit insertion_time;
     time_unit query_time;
     std::size_t memory_usage;
+    StructureStats stats;
 };
 
 std::ostream& operator<<(std::ostream&, Result const&);
+
+struct FilterResult {
+    std::string key_type;
+    std::size_t elements;
+    double target_rate;
+    double false_positive_rate;
+    std::size_t filter_memory;
+    time_unit miss_time;
+    time_unit filtered_miss_time;
+};
+
+std::ostream& operator<<(std::ostream&, FilterResult const&);
+
+struct ScanResult {
+    std::string key_type;
+    std::size_t elements;
+    unsigned int threads;
+    time_unit scan_time;
+};
+
+std::ostream& operator<<(std::ostream&, ScanResult const&);
+
+struct BuildResult {
+    std::string key_type;
+    std::size_t elements;
+    unsigned int threads;
+    time_unit insertion_time;
+    time_unit build_time;
+};
+
+std::ostream& operator<<(std::ostream&, BuildResult const&);
+
+struct LazyResult {
+    std::string key_type;
+    std::size_t elements;
+    time_unit erase_time;
+    time_unit lazy_erase_time;
+    time_unit compact_time;
+    time_unit query_time;
+    time_unit tombstone_query_time;
+};
+
+std::ostream& operator<<(std::ostream&, LazyResult const&);
+
+struct TuneResult {
+    std::string key_type;
+    std::size_t elements;
+    double probability;
+    std::size_t max_level;
+    time_unit insertion_time;
+    time_unit query_time;
+    std::size_t memory_usage;
+    bool pareto;
+};
+
+std::ostream& operator<<(std::ostream&, TuneResult const&);
+
+struct ZipfResult {
+    std::string key_type;
+    std::size_t elements;
+    double skew;
+    time_unit query_time;
+    time_unit adaptive_query_time;
+    time_unit adapt_time;
+};
+
+std::ostream& operator<<(std::ostream&, ZipfResult const&);
+
+struct ThroughputResult {
+    std::string structure;
+    std::string key_type;
+    std::size_t elements;
+    unsigned int threads;
+    time_unit op_time;
+    time_unit batch_op_time;
+};
+
+std::ostream& operator<<(std::ostream&, ThroughputResult const&);
+
+struct CacheResult {
+    std::string structure;
+    std::string key_type;
+    std::size_t elements;
+    double skew;
+    double hit_ratio;
+    time_unit query_time;
+    time_unit cached_query_time;
+};
+
+std::ostream& operator<<(std::ostream&, CacheResult const&);
+
+struct SmallResult {
+    std::string key_type;
+    std::size_t elements;
+    std::size_t memory_usage;
+    std::size_t small_memory_usage;
+    time_unit query_time;
+    time_unit small_query_time;
+};
+
+std::ostream& operator<<(std::ostream&, SmallResult const&);
+
+struct PagedResult {
+    std::string key_type;
+    std::size_t elements;
+    std::size_t leaf_pages;
+    std::size_t pool_pages;
+    time_unit query_time;
+    time_unit paged_query_time;
+    double reads_per_query;
+    time_unit scan_time;
+    time_unit paged_scan_time;
+};
+
+std::ostream& operator<<(std::ostream&, PagedResult const&);
+
+struct BatchResult {
+    std::string structure;
+    std::string key_type;
+    std::size_t elements;
+    std::size_t group;
+    time_unit query_time;
+    time_unit batch_query_time;
+};
+
+std::ostream& operator<<(std::ostream&, BatchResult const&);
+
+// Percentiles of single operation times; p999 is the 99.9th percentile.
+struct LatencyResult {
+    std::string structure;
+    std::string key_type;
+    std::size_t elements;
+    time_unit insert_p50;
+    time_unit insert_p99;
+    time_unit insert_p999;
+    time_unit query_p50;
+    time_unit query_p99;
+    time_unit query_p999;
+    time_unit erase_p50;
+    time_unit erase_p99;
+    time_unit erase_p999;
+};
+
+std::ostream& operator<<(std::ostream&, LatencyResult const&);
+
+// Comparisons are per lookup.
+struct CompareResult {
+    std::string key_type;
+    std::size_t elements;
+    double two_way_comparisons;
+    double three_way_comparisons;
+    time_unit two_way_query_time;
+    time_unit three_way_query_time;
+};
+
+std::ostream& operator<<(std::ostream&, CompareResult const&);
+
+// Per entry of the batch; the batch includes entries already in the map.
+struct MergeResult {
+    std::string key_type;
+    std::size_t elements;
+    std::size_t batch;
+    time_unit insertion_time;
+    time_unit merge_time;
+};
+
+std::ostream& operator<<(std::ostream&, MergeResult const&);
+
+// Per prefix dropped.
+struct PrefixResult {
+    std::size_t elements;
+    std::size_t prefixes;
+    time_unit erase_if_time;
+    time_unit erase_prefix_time;
+};
+
+std::ostream& operator<<(std::ostream&, PrefixResult const&);
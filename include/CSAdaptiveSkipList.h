@@ -0,0 +1,219 @@
+/*
+   Description: Header file for AdaptiveKeyedSkipList
+                KeyedSkipList whose node levels follow lookup frequency.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSAdaptiveSkipListH
+#define CSAdaptiveSkipListH
+
+#include <utility>
+#include <iterator>
+#include <functional>
+#include "CSSkipListTools.h"
+#include "CSIterators.h"
+#include "CSBloomFilter.h"
+
+namespace CS
+{
+#define CSBIDI(a,b) a
+#define CSUNIQUE(a,b) a
+#define CSINDEX(a,b) b
+#define CSKEY(a,b) a
+#define CSLEVEL(a,b) a
+#define CSFILTER(a,b) a
+#define CSLAZY(a,b) a
+#define CSSTATIC(a,b) b
+#define CSADAPT(a,b) a
+
+// Like KeyedSkipList, but find() counts hits per node and adapt() moves
+// frequently found keys up the levels.  Call adapt() every so often, e.g.
+// after each batch of lookups; it costs one pass over the list.  Only the
+// non-const find() counts, so lookups through a const list don't adapt.
+template <class K, class T, class Pr, class R, class A>
+class AdaptiveKeyedSkipList
+{
+public:
+  typedef CSUNIQUE(CSKEY(uniquekey_tag,unique_tag),CSKEY(multikey_tag,multi_tag)) tag;
+  typedef AdaptiveKeyedSkipList<K,T,Pr,R,A> container_type;
+  typedef BidiIterator<container_type> T0;
+  typedef ConstBidiIterator<container_type> T1;
+  friend class BidiIterator<container_type>;
+  friend class ConstBidiIterator<container_type>;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef AdaptiveBidiNode<value_type> node_type;
+  typedef T0 iterator;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T const_mapped_type;
+  typedef const T& const_mapped_type_reference;
+  typedef const value_type& const_reference;
+  typedef T1 const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+  typedef Pr key_compare;
+  typedef KeyOrder<Pr, K> key_order;
+  typedef GeometricLevels level_generator;
+  typedef CountingBloomFilter<K,std::hash<K>,A> filter_type;
+
+  class value_compare
+    : public std::binary_function<value_type, value_type, bool>
+  {
+  friend class AdaptiveKeyedSkipList<K,T,Pr,R,A>;
+  public:
+    bool operator()(const value_type& left, const value_type& right) const
+      {return (comp(left.first, right.first)); }
+  protected:
+    value_compare(const key_compare &pr) : comp(pr) {}
+    key_compare comp;
+  };
+
+private:
+  R rng;
+  key_compare KeyCompare;
+  value_compare ValueCompare;
+  size_type maxLevel; //!< Maximum number of forward pointers possible, at most 255.
+  size_type level;    //!< The maximum number of forward pointers on any given container currently in use.
+  node_type *head,*tail; //!< Start and end containers.
+  double probability; //!< Probability to go to the next level.
+  size_type items; //!< Number of items in the list.
+  mutable std::pair<size_type,node_type*> *update;
+  filter_type *bloom; //!< Optional membership filter.  NULL when disabled.
+  bool lazy; //!< erase() marks nodes dead instead of freeing them.
+  size_type tombstones; //!< Number of dead nodes still linked.
+  std::vector<node_type*, typename A::template rebind<node_type*>::other> graveyard; //!< Dead nodes waiting for compact().
+  CSDefineInit
+  node_type* Alloc(size_type level, const value_type &obj) CSAlloc2(A, level,obj,node_type)
+  node_type* Alloc(size_type level) CSAlloc(A, level,node_type)
+  void Free(node_type *item) CSFree(A, item,node_type)
+  CSDefineGenerateRandomLevel
+  CSDefineAdjustLevels
+  CSDefineScanKey
+  CSDefineScanVal
+  CSDefineScanIterator
+  CSDefineScanNode
+  CSDefineScanBack
+  CSDefineLazyNodes
+public:
+
+  CheckSkipNodes
+  CSDefineStats
+
+  AdaptiveKeyedSkipList() : ValueCompare(Pr()) { CSInitDefault; }
+  explicit AdaptiveKeyedSkipList(size_type maxNodes) : ValueCompare(Pr()) { CSInitMaxNodes; }
+  AdaptiveKeyedSkipList(double probability, size_type maxLevel) : ValueCompare(Pr()) { CSInitPM; }
+  AdaptiveKeyedSkipList(const container_type &source) : ValueCompare(source.ValueCompare), KeyCompare(source.KeyCompare) { CSInitCore(source.probability, source.maxLevel) if (source.bloom!=NULL) enable_filter(source.bloom->expected_items(),source.bloom->target_rate()); CSCopyITIT(const_iterator, source.begin(),source.end(),insert); lazy = source.lazy; }
+  template<class InIt> AdaptiveKeyedSkipList(InIt first, InIt last) : ValueCompare(Pr()) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> AdaptiveKeyedSkipList(InIt first, InIt last, double probability, size_type maxLevel) : ValueCompare(Pr()) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> AdaptiveKeyedSkipList(InIt first, InIt last, size_type maxNodes) : ValueCompare(Pr()) { CSInitMaxNodes; CSCopyITIT(InIt, first,last,insert); }
+  explicit AdaptiveKeyedSkipList(const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitDefault; }
+  template<class InIt> AdaptiveKeyedSkipList(InIt first, InIt last, const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> AdaptiveKeyedSkipList(InIt first, InIt last, const key_compare& comp, double probability, size_type maxLevel) : ValueCompare(comp), KeyCompare(comp) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> AdaptiveKeyedSkipList(InIt first, InIt last, const key_compare& comp, size_type maxNodes) : ValueCompare(comp), KeyCompare(comp) { CSInitMaxNodes; CSCopyITIT(InIt, first,last,insert); }
+  ~AdaptiveKeyedSkipList() { clear(); delete bloom; }
+  CSDefineOperatorEqual
+
+  CSDefineBeginEnd
+  CSDefineRBeginEnd
+  CSDefineSize
+  CSDefineEmpty
+  CSDefineFront
+  CSDefineBackBidi
+  CSDefinePopFront
+  CSDefinePopBackBidi
+  CSDefineAssignITIT(insert)
+
+  CSDefineInsertVal
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; } // Don't use this.  Calls insert(const value_type& type);
+  template<class InIt> void insert(InIt first, InIt last) { CSCopyITIT(InIt, first, last, insert); }
+
+  CSDefineErase
+  CSDefineEraseITIT
+  CSDefineEraseKey
+
+  CSDefineClear
+  CSDefineDestroy
+  void swap(container_type& right) { CSSwapCore std::swap(ValueCompare, right.ValueCompare); std::swap(KeyCompare, right.KeyCompare); }
+  CSDefineEraseIf
+  CSDefineDestroyIf
+
+  CSDefineCut
+  CSDefineFilter
+  CSDefineSplit
+  CSDefineAssignSorted
+  CSDefineInsertBatch
+  CSDefineLazy
+  CSDefineAdapt
+  CSDefineOperatorArrayMap
+  CSDefineOperatorArrayMap2
+
+  CSDefineKeyCompare(KeyCompare)
+  CSDefineValueCompare(ValueCompare)
+  CSDefineMaxSize
+
+  const key_type& key(const_reference value) const {return value.first;}
+  mapped_type_reference value(reference value) const {return value.second;}
+  const_mapped_type_reference value(const_reference value) const {return value.second;}
+  CSDefineFind
+  CSDefineFindSteps
+  CSDefineCount
+  CSDefineLowerBound
+  CSDefineUpperBound
+  CSDefineEqualRange
+  CSDefinePrefix
+};
+
+template <class K, class T, class Pr, class R, class A>
+bool operator==(const AdaptiveKeyedSkipList<K,T,Pr,R,A> &left, const AdaptiveKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+
+}
+
+template <class K, class T, class Pr, class R, class A>
+bool operator<(const AdaptiveKeyedSkipList<K,T,Pr,R,A> &left, const AdaptiveKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return lexicographical_compare(left.begin(),left.end(),right.begin(),right.end(),left.value_comp());
+}
+
+#define csarg1 template<class K, class T, class Pr, class R, class A>
+#define csarg2 AdaptiveKeyedSkipList<K,T,Pr,R,A>
+CSDefineCompOps(csarg1, csarg2)
+#undef csarg1
+#undef csarg2
+
+#undef CSFILTER
+#undef CSLAZY
+#undef CSADAPT
+#undef CSSTATIC
+#undef CSKEY
+#undef CSINDEX
+#undef CSUNIQUE
+#undef CSBIDI
+#undef CSLEVEL
+
+}
+
+
+#endif
+
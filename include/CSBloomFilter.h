@@ -0,0 +1,151 @@
+/*
+   Description: Header file for CountingBloomFilter
+                Approximate membership filter kept in front of keyed skiplists.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSBloomFilterH
+#define CSBloomFilterH
+
+#include <vector>
+#include <functional>
+#include <stddef.h>
+#include <math.h>
+
+namespace CS
+{
+
+// Counting Bloom filter with 4 bit counters, two counters per byte.
+// contains() never gives a false negative for a key that was inserted and
+// not yet erased.  A counter that reaches 15 sticks there, so erasing can
+// never clear a slot another key still depends on.
+// The counters of one key all fall in the same 64 byte block, so a lookup
+// costs one cache miss whatever the number of hashes.
+template <class K, class H, class A>
+class CountingBloomFilter
+{
+public:
+  typedef size_t size_type;
+  typedef K key_type;
+  typedef H hasher;
+  typedef typename A::template rebind<unsigned char>::other allocator_type;
+
+  CountingBloomFilter(size_type expectedItems, double falsePositiveRate)
+    : expected(expectedItems), target(falsePositiveRate)
+  {
+    if (expected<1) expected = 1;
+    if ((target<=0.0)||(target>=1.0)) target = 0.01;
+    double ln2 = log(2.0);
+    double m = ceil(-(double)expected*log(target)/(ln2*ln2));
+    blocks = ((size_type)m+BlockSlots-1)/BlockSlots;
+    if (blocks<1) blocks = 1;
+    slots = blocks*BlockSlots;
+    hashes = (unsigned int)floor(((double)slots/(double)expected)*ln2+0.5);
+    if (hashes<1) hashes = 1;
+    if (hashes>16) hashes = 16;
+    counters.assign(blocks*BlockBytes, 0);
+  }
+
+  void insert(const key_type &keyval)
+  {
+    unsigned char *block;
+    unsigned int h1, h2;
+    Hash(keyval, block, h1, h2);
+    for(unsigned int i=0;i<hashes;i++)
+    {
+      unsigned int slot = (h1+i*h2)&(BlockSlots-1);
+      unsigned int c = Get(block, slot);
+      if (c<15) Set(block, slot, c+1);
+    }
+  }
+
+  void erase(const key_type &keyval)
+  {
+    unsigned char *block;
+    unsigned int h1, h2;
+    Hash(keyval, block, h1, h2);
+    for(unsigned int i=0;i<hashes;i++)
+    {
+      unsigned int slot = (h1+i*h2)&(BlockSlots-1);
+      unsigned int c = Get(block, slot);
+      if ((c!=0)&&(c<15)) Set(block, slot, c-1);
+    }
+  }
+
+  bool contains(const key_type &keyval) const
+  {
+    unsigned char *block;
+    unsigned int h1, h2;
+    Hash(keyval, block, h1, h2);
+    for(unsigned int i=0;i<hashes;i++)
+    {
+      if (Get(block, (h1+i*h2)&(BlockSlots-1))==0) return false;
+    }
+    return true;
+  }
+
+  void clear() { counters.assign(counters.size(), 0); }
+
+  size_type expected_items() const { return expected; }
+  double target_rate() const { return target; }
+  size_type counter_count() const { return slots; }
+  unsigned int hash_count() const { return hashes; }
+  size_type memory_usage() const { return sizeof(*this)+counters.capacity(); }
+
+  // Expected false positive rate once 'items' keys are in the filter.
+  double false_positive_rate(size_type items) const
+  {
+    return pow(1.0-exp(-(double)hashes*(double)items/(double)slots), (double)hashes);
+  }
+
+private:
+  size_type expected; //!< Number of keys the filter was sized for.
+  double target;      //!< False positive rate the filter was sized for.
+  enum { BlockBytes = 64, BlockSlots = 2*BlockBytes };
+  size_type blocks;   //!< Number of 64 byte blocks.
+  size_type slots;    //!< Number of counters.
+  unsigned int hashes; //!< Number of counters touched per key.
+  mutable std::vector<unsigned char, allocator_type> counters;
+
+  static unsigned int Get(const unsigned char *block, unsigned int slot)
+  {
+    return (block[slot>>1]>>((slot&1)<<2))&0xF;
+  }
+
+  static void Set(unsigned char *block, unsigned int slot, unsigned int c)
+  {
+    unsigned int shift = (slot&1)<<2;
+    block[slot>>1] = (unsigned char)((block[slot>>1]&~(0xF<<shift))|(c<<shift));
+  }
+
+  // Picks the block from the high half of the hash and derives the counter
+  // positions inside it by double hashing on the low half.  std::hash is the
+  // identity for integers, so the result goes through a 64 bit finalizer.
+  void Hash(const key_type &keyval, unsigned char *&block, unsigned int &h1, unsigned int &h2) const
+  {
+    unsigned long long x = (unsigned long long)hasher()(keyval);
+    x ^= x>>33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x>>33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x>>33;
+    size_type b = (size_type)(((x>>32)*(unsigned long long)blocks)>>32);
+    block = &counters[b*BlockBytes];
+    h1 = (unsigned int)x;
+    h2 = (unsigned int)(x>>7)|1;
+  }
+};
+
+}
+
+#endif
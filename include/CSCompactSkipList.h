@@ -0,0 +1,635 @@
+/*
+   Description: Header file for ChunkArena and CompactKeyedSkipList
+                Singly linked skiplist that acts like a map and links its
+                nodes through 32-bit indices into an arena.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSCompactSkipListH
+#define CSCompactSkipListH
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "CSSkipListTools.h"
+
+namespace CS
+{
+
+// Growable array of T in chunks of 2^Bits, addressed by 32-bit index.
+// Chunks never move, so references stay valid while the arena grows, and
+// nothing in it refers to an address, so it can be written out and read
+// back as raw bytes.  Slots are raw memory; the user constructs in them.
+template<class T, class A, unsigned int Bits>
+class ChunkArena
+{
+public:
+  typedef typename A::template rebind<T>::other allocator_type;
+  static const uint32_t ChunkSize = 1u<<Bits;
+
+  ChunkArena() : used(0) {}
+  ~ChunkArena() { release(); }
+
+  T& operator[](uint32_t i) { return chunks[i>>Bits][i&(ChunkSize-1)]; }
+  const T& operator[](uint32_t i) const { return chunks[i>>Bits][i&(ChunkSize-1)]; }
+
+  uint32_t size() const { return used; }
+  size_t capacity() const { return chunks.size()*ChunkSize; }
+  size_t memory_usage() const { return capacity()*sizeof(T)+chunks.capacity()*sizeof(T*); }
+
+  // Hands out n consecutive slots, n no more than ChunkSize.  Runs never
+  // straddle two chunks; the slots skipped to ensure that are wasted.
+  uint32_t extend(uint32_t n)
+  {
+    uint64_t first = used;
+    if ((first&(ChunkSize-1))+n>ChunkSize) first = (first+ChunkSize-1)&~(uint64_t)(ChunkSize-1);
+    if (first+n>0xFFFFFFFFull) throw std::length_error("ChunkArena: out of 32-bit indices");
+    while (first+n>capacity())
+    {
+      allocator_type alloc;
+      chunks.push_back(alloc.allocate(ChunkSize));
+    }
+    used = (uint32_t)(first+n);
+    return (uint32_t)first;
+  }
+
+  void release()
+  {
+    allocator_type alloc;
+    for(size_t i=0;i<chunks.size();i++) alloc.deallocate(chunks[i], ChunkSize);
+    chunks.clear();
+    used = 0;
+  }
+
+  void swap(ChunkArena &right)
+  {
+    chunks.swap(right.chunks);
+    std::swap(used, right.used);
+  }
+
+  void write(FILE *file) const
+  {
+    for(uint32_t i=0;i<chunks.size();i++)
+    {
+      size_t count = std::min<size_t>(ChunkSize, used-((size_t)i<<Bits));
+      if (fwrite(chunks[i], sizeof(T), count, file)!=count) throw std::runtime_error("ChunkArena: short write");
+    }
+  }
+
+  // Replaces the contents with 'count' slots read from file.
+  void read(FILE *file, uint32_t count)
+  {
+    release();
+    while (used<count) extend(std::min<uint32_t>(ChunkSize, count-used));
+    for(uint32_t i=0;i<chunks.size();i++)
+    {
+      size_t n = std::min<size_t>(ChunkSize, used-((size_t)i<<Bits));
+      if (fread(chunks[i], sizeof(T), n, file)!=n) throw std::runtime_error("ChunkArena: short read");
+    }
+  }
+
+private:
+  ChunkArena(const ChunkArena&);
+  ChunkArena& operator=(const ChunkArena&);
+
+  std::vector<T*, typename A::template rebind<T*>::other> chunks;
+  uint32_t used; //!< Slots handed out.
+};
+
+// Iterator over a CompactKeyedSkipList.  Holds the node's index, so it
+// stays valid until that node is erased.
+template<class container_type, class V>
+class CompactIterator : public std::iterator<std::forward_iterator_tag, typename std::remove_const<V>::type, ptrdiff_t, V*, V&>
+{
+public:
+// WARNING:  DO NOT WRITE TO THE FOLLOWING MEMBERS!!!
+  const container_type *container;
+  uint32_t node;
+
+  CompactIterator() : container(NULL), node(container_type::nil) {}
+  CompactIterator(const container_type *container, uint32_t node) : container(container), node(node) {}
+  template<class V2> CompactIterator(const CompactIterator<container_type,V2> &right) : container(right.container), node(right.node) {}
+
+  V& operator*() const { return const_cast<V&>(container->Object(node)); }
+  V* operator->() const { return &**this; }
+
+  CompactIterator& operator++()
+  {
+    node = container->Link(node, 0);
+    return *this;
+  }
+
+  CompactIterator operator++(int)
+  {
+    CompactIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  template<class V2> bool operator==(const CompactIterator<container_type,V2> &right) const { return node==right.node; }
+  template<class V2> bool operator!=(const CompactIterator<container_type,V2> &right) const { return node!=right.node; }
+};
+
+// Map on a singly linked skiplist whose nodes sit in a ChunkArena and link
+// to each other through 32-bit indices, so a link costs half of what a
+// pointer does.  A node holds the object, its level 0 link and the index of
+// its higher links, which live in a second arena; up to 4G nodes fit.
+// Erased nodes and link runs go on free lists for reuse.
+//
+// Nothing refers to an address, so save() and load() write and read the
+// arenas as raw bytes when K and T are trivially copyable.
+template <class K, class T, class Pr, class R, class A>
+class CompactKeyedSkipList
+{
+public:
+  typedef CompactKeyedSkipList<K,T,Pr,R,A> container_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T& const_mapped_type_reference;
+  typedef CompactIterator<container_type, value_type> iterator;
+  typedef CompactIterator<container_type, const value_type> const_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+  typedef Pr key_compare;
+  typedef GeometricLevels level_generator;
+  typedef uint32_t link_type;
+
+  static const link_type nil = 0xFFFFFFFF; //!< Link past the last node.
+  friend class CompactIterator<container_type, value_type>;
+  friend class CompactIterator<container_type, const value_type>;
+
+private:
+  struct Node
+  {
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type object;
+    link_type next; //!< Level 0 link, or the next free node.
+    link_type upper; //!< Links for levels 1 to level, in the link arena.
+    unsigned char level;
+  };
+
+  static const link_type head = 0; //!< Node 0 is the head and holds no object.
+
+  R rng;
+  key_compare KeyCompare;
+  size_type maxLevel; //!< Maximum number of forward links possible.
+  size_type level;    //!< Highest level currently in use.
+  double probability; //!< Probability to go to the next level.
+  size_type items;    //!< Number of items in the list.
+  ChunkArena<Node, A, 8> nodes;
+  ChunkArena<link_type, A, 10> links;
+  link_type freeNodes; //!< Erased nodes, chained through next.
+  std::vector<link_type, typename A::template rebind<link_type>::other> freeLinks; //!< freeLinks[l] chains free runs of l links.
+  mutable std::vector<link_type, typename A::template rebind<link_type>::other> update;
+
+  CSDefineGenerateRandomLevel
+
+  void Init(double probability, size_type maxLevel)
+  {
+    this->probability = level_generator::probability(probability);
+    this->maxLevel = (maxLevel<255) ? maxLevel : 255;
+    level = 0;
+    items = 0;
+    freeNodes = nil;
+    freeLinks.assign(this->maxLevel+1, nil);
+    update.assign(this->maxLevel+1, head);
+    nodes.extend(1);
+    Node &h = nodes[head];
+    h.level = (unsigned char)this->maxLevel;
+    h.next = nil;
+    h.upper = (this->maxLevel>0) ? links.extend((link_type)this->maxLevel) : nil;
+    for(unsigned int i=1;i<=this->maxLevel;i++) Link(head, i) = nil;
+  }
+
+  link_type& Link(link_type node, size_type i) { return (i==0) ? nodes[node].next : links[nodes[node].upper+(link_type)i-1]; }
+  link_type Link(link_type node, size_type i) const { return (i==0) ? nodes[node].next : links[nodes[node].upper+(link_type)i-1]; }
+  value_type& Object(link_type node) { return *reinterpret_cast<value_type*>(&nodes[node].object); }
+  const value_type& Object(link_type node) const { return *reinterpret_cast<const value_type*>(&nodes[node].object); }
+
+  link_type NewNode(unsigned int newLevel, const value_type &val)
+  {
+    link_type node;
+    if (freeNodes!=nil)
+    {
+      node = freeNodes;
+      freeNodes = nodes[node].next;
+    }
+    else node = nodes.extend(1);
+
+    link_type run = nil;
+    try
+    {
+      if (newLevel>0)
+      {
+        if (freeLinks[newLevel]!=nil)
+        {
+          run = freeLinks[newLevel];
+          freeLinks[newLevel] = links[run];
+        }
+        else run = links.extend(newLevel);
+      }
+      new(&nodes[node].object) value_type(val);
+    }
+    catch(...)
+    {
+      if (run!=nil)
+      {
+        links[run] = freeLinks[newLevel];
+        freeLinks[newLevel] = run;
+      }
+      nodes[node].next = freeNodes;
+      freeNodes = node;
+      throw;
+    }
+    Node &n = nodes[node];
+    n.level = (unsigned char)newLevel;
+    n.upper = run;
+    for(unsigned int i=0;i<=newLevel;i++) Link(node, i) = nil;
+    return node;
+  }
+
+  void FreeNode(link_type node)
+  {
+    Object(node).~value_type();
+    Node &n = nodes[node];
+    if (n.level>0)
+    {
+      links[n.upper] = freeLinks[n.level];
+      freeLinks[n.level] = n.upper;
+    }
+    n.next = freeNodes;
+    freeNodes = node;
+  }
+
+  // Fills update with the last node before keyval on every level.
+  void Scan(const key_type &keyval) const
+  {
+    link_type cursor = head;
+    for(int i=(int)level;i>=0;i--)
+    {
+      link_type node1 = Link(cursor, i);
+      while ((node1!=nil)&&(KeyCompare(Object(node1).first,keyval)))
+      {
+        cursor = node1;
+        node1 = Link(node1, i);
+      }
+      update[i] = cursor;
+    }
+  }
+
+  link_type LowerNode(const key_type &keyval) const
+  {
+    link_type cursor = head;
+    for(int i=(int)level;i>=0;i--)
+    {
+      link_type node1 = Link(cursor, i);
+      while ((node1!=nil)&&(KeyCompare(Object(node1).first,keyval)))
+      {
+        cursor = node1;
+        node1 = Link(node1, i);
+      }
+    }
+    return Link(cursor, 0);
+  }
+
+  link_type FindNode(const key_type &keyval) const
+  {
+    link_type node = LowerNode(keyval);
+    if ((node==nil)||(KeyCompare(keyval,Object(node).first))) return nil;
+    return node;
+  }
+
+  void AdjustLevels()
+  {
+    while ((level>0)&&(Link(head, level)==nil)) level--;
+  }
+
+  // Unlinks the node after update[0], which must hold keyval.
+  link_type Unlink()
+  {
+    link_type node = Link(update[0], 0);
+    for(unsigned int i=0;(i<=level)&&(Link(update[i], i)==node);i++) Link(update[i], i) = Link(node, i);
+    link_type next = Link(node, 0);
+    FreeNode(node);
+    items--;
+    AdjustLevels();
+    return next;
+  }
+
+  void DestroyObjects()
+  {
+    for(link_type node=Link(head, 0);node!=nil;node=Link(node, 0)) Object(node).~value_type();
+  }
+
+  template<class InIt> void CopyFrom(InIt first, InIt last)
+  {
+    for(InIt i=first;i!=last;++i) insert(*i);
+  }
+
+public:
+  CompactKeyedSkipList() : KeyCompare(Pr()) { CSInitDefault; }
+  explicit CompactKeyedSkipList(size_type maxNodes) : KeyCompare(Pr()) { CSInitMaxNodes; }
+  CompactKeyedSkipList(double probability, size_type maxLevel) : KeyCompare(Pr()) { CSInitPM; }
+  explicit CompactKeyedSkipList(const key_compare& comp) : KeyCompare(comp) { CSInitDefault; }
+  CompactKeyedSkipList(const container_type &source) : KeyCompare(source.KeyCompare) { Init(source.probability, source.maxLevel); CopyFrom(source.begin(), source.end()); }
+  template<class InIt> CompactKeyedSkipList(InIt first, InIt last) : KeyCompare(Pr()) { CSInitDefault; CopyFrom(first, last); }
+  ~CompactKeyedSkipList() { DestroyObjects(); }
+
+  container_type& operator=(const container_type &source)
+  {
+    if (this==&source) return *this;
+    container_type temp(source);
+    swap(temp);
+    return *this;
+  }
+
+  iterator begin() { return iterator(this, Link(head, 0)); }
+  iterator end() { return iterator(this, nil); }
+  const_iterator begin() const { return const_iterator(this, Link(head, 0)); }
+  const_iterator end() const { return const_iterator(this, nil); }
+
+  size_type size() const { return items; }
+  bool empty() const { return items==0; }
+  size_type max_size() const { return nil-1; }
+
+  slpair insert(const value_type &val)
+  {
+    Scan(val.first);
+    link_type next = Link(update[0], 0);
+    if ((next!=nil)&&(!KeyCompare(val.first,Object(next).first))) return slpair(iterator(this, next), false);
+
+    unsigned int newLevel = GenerateRandomLevel();
+    link_type node = NewNode(newLevel, val);
+    if (newLevel>level)
+    {
+      for(size_type i=level+1;i<=newLevel;i++) update[i] = head;
+      level = newLevel;
+    }
+    for(unsigned int i=0;i<=newLevel;i++)
+    {
+      Link(node, i) = Link(update[i], i);
+      Link(update[i], i) = node;
+    }
+    items++;
+    return slpair(iterator(this, node), true);
+  }
+
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; }
+  template<class InIt> void insert(InIt first, InIt last) { CopyFrom(first, last); }
+
+  iterator erase(const iterator &where)
+  {
+    if (where.node==nil) return end();
+    Scan(Object(where.node).first);
+    if (Link(update[0], 0)!=where.node) return end();
+    return iterator(this, Unlink());
+  }
+
+  size_type erase(const key_type &keyval)
+  {
+    Scan(keyval);
+    link_type node = Link(update[0], 0);
+    if ((node==nil)||(KeyCompare(keyval,Object(node).first))) return 0;
+    Unlink();
+    return 1;
+  }
+
+  void clear()
+  {
+    DestroyObjects();
+    nodes.release();
+    links.release();
+    Init(probability, maxLevel);
+  }
+
+  void swap(container_type &right)
+  {
+    std::swap(rng, right.rng);
+    std::swap(KeyCompare, right.KeyCompare);
+    std::swap(maxLevel, right.maxLevel);
+    std::swap(level, right.level);
+    std::swap(probability, right.probability);
+    std::swap(items, right.items);
+    nodes.swap(right.nodes);
+    links.swap(right.links);
+    std::swap(freeNodes, right.freeNodes);
+    freeLinks.swap(right.freeLinks);
+    update.swap(right.update);
+  }
+
+  mapped_type_reference operator[](const key_type& key)
+  {
+    return insert(value_type(key, mapped_type())).first->second;
+  }
+
+  key_compare key_comp() const { return KeyCompare; }
+
+  iterator find(const key_type &keyval) { return iterator(this, FindNode(keyval)); }
+  const_iterator find(const key_type &keyval) const { return const_iterator(this, FindNode(keyval)); }
+  size_type count(const key_type &keyval) const { return (FindNode(keyval)==nil) ? 0 : 1; }
+  iterator lower_bound(const key_type &keyval) { return iterator(this, LowerNode(keyval)); }
+  const_iterator lower_bound(const key_type &keyval) const { return const_iterator(this, LowerNode(keyval)); }
+
+  iterator upper_bound(const key_type &keyval)
+  {
+    link_type node = LowerNode(keyval);
+    if ((node!=nil)&&(!KeyCompare(keyval,Object(node).first))) node = Link(node, 0);
+    return iterator(this, node);
+  }
+
+  const_iterator upper_bound(const key_type &keyval) const
+  {
+    link_type node = LowerNode(keyval);
+    if ((node!=nil)&&(!KeyCompare(keyval,Object(node).first))) node = Link(node, 0);
+    return const_iterator(this, node);
+  }
+
+  ipair equal_range(const key_type &keyval) { return ipair(lower_bound(keyval), upper_bound(keyval)); }
+  const_ipair equal_range(const key_type &keyval) const { return const_ipair(lower_bound(keyval), upper_bound(keyval)); }
+
+  SkipListStats stats(size_type samples = 1024) const
+  {
+    SkipListStats s;
+    s.items = items;
+    s.level = (unsigned int)level;
+    s.maxLevel = (unsigned int)maxLevel;
+    s.nodesPerLevel.assign(maxLevel+1, 0);
+    s.sampled = 0;
+    s.maxPath = 0;
+    s.nodeBytes = 0;
+    s.pointerBytes = 0;
+
+    size_type stride = (samples==0) ? 0 : (items+samples-1)/samples;
+    size_type pos = 0;
+    size_type totalPath = 0;
+    for(link_type node=Link(head, 0);node!=nil;node=Link(node, 0),pos++)
+    {
+      unsigned int l = nodes[node].level;
+      s.nodesPerLevel[l]++;
+      s.nodeBytes += sizeof(Node)+l*sizeof(link_type);
+      s.pointerBytes += (l+1)*sizeof(link_type);
+      if ((stride==0)||(pos%stride!=0)) continue;
+
+      /* One step per drop to a lower level and one per link followed. */
+      size_type path = level+1;
+      link_type cursor = head;
+      for(int i=(int)level;i>=0;i--)
+      {
+        link_type node1 = Link(cursor, i);
+        while ((node1!=nil)&&(KeyCompare(Object(node1).first,Object(node).first)))
+        {
+          cursor = node1;
+          node1 = Link(node1, i);
+          path++;
+        }
+      }
+      totalPath += path;
+      if (path>s.maxPath) s.maxPath = path;
+      s.sampled++;
+    }
+    s.averagePath = (s.sampled==0) ? 0.0 : (double)totalPath/(double)s.sampled;
+    s.sentinelBytes = sizeof(Node)+maxLevel*sizeof(link_type);
+    s.updateBytes = (maxLevel+1)*sizeof(update[0]);
+    s.filterBytes = 0;
+    s.deadNodes = 0;
+    return s;
+  }
+
+  // Writes the list to path as raw arenas.  Only for trivially copyable
+  // keys and values, and only readable on the same platform.
+  void save(const char *path) const
+  {
+    static_assert(std::is_trivially_copyable<K>::value&&std::is_trivially_copyable<T>::value, "CompactKeyedSkipList: save() needs trivially copyable K and T");
+    FILE *file = fopen(path, "wb");
+    if (file==NULL) throw std::runtime_error("CompactKeyedSkipList: cannot open file");
+    try
+    {
+      uint64_t header[6] = {sizeof(Node), maxLevel, level, items, nodes.size(), links.size()};
+      if ((fwrite(Magic(), 8, 1, file)!=1)||
+          (fwrite(header, sizeof(header), 1, file)!=1)||
+          (fwrite(&probability, sizeof(probability), 1, file)!=1)||
+          (fwrite(&freeNodes, sizeof(freeNodes), 1, file)!=1)||
+          (fwrite(&freeLinks[0], sizeof(link_type), freeLinks.size(), file)!=freeLinks.size()))
+        throw std::runtime_error("CompactKeyedSkipList: short write");
+      nodes.write(file);
+      links.write(file);
+    }
+    catch(...)
+    {
+      fclose(file);
+      throw;
+    }
+    if (fclose(file)!=0) throw std::runtime_error("CompactKeyedSkipList: short write");
+  }
+
+  // Replaces the contents with a list written by save().  A file that is
+  // not one, or whose header points outside its arenas, leaves the list
+  // alone; one cut short leaves it empty.
+  void load(const char *path)
+  {
+    static_assert(std::is_trivially_copyable<K>::value&&std::is_trivially_copyable<T>::value, "CompactKeyedSkipList: load() needs trivially copyable K and T");
+    FILE *file = fopen(path, "rb");
+    if (file==NULL) throw std::runtime_error("CompactKeyedSkipList: cannot open file");
+    char magic[8];
+    uint64_t header[6];
+    double newProbability;
+    link_type newFreeNodes;
+    std::vector<link_type, typename A::template rebind<link_type>::other> newFreeLinks;
+    bool valid = (fread(magic, 8, 1, file)==1)&&(fread(header, sizeof(header), 1, file)==1)&&
+                 (memcmp(magic, Magic(), 8)==0)&&(header[0]==sizeof(Node))&&(header[1]<=255)&&
+                 (header[2]<=header[1])&&(header[4]>0)&&(header[4]<=0xFFFFFFFF)&&(header[5]<=0xFFFFFFFF);
+    if (valid)
+    {
+      newFreeLinks.assign((size_t)header[1]+1, nil);
+      valid = (fread(&newProbability, sizeof(newProbability), 1, file)==1)&&
+              (fread(&newFreeNodes, sizeof(newFreeNodes), 1, file)==1)&&
+              (fread(&newFreeLinks[0], sizeof(link_type), newFreeLinks.size(), file)==newFreeLinks.size())&&
+              ((newFreeNodes==nil)||(newFreeNodes<header[4]));
+      for(size_t i=0;valid&&(i<newFreeLinks.size());i++) valid = (newFreeLinks[i]==nil)||(newFreeLinks[i]<header[5]);
+    }
+    if (!valid)
+    {
+      fclose(file);
+      throw std::runtime_error("CompactKeyedSkipList: not a compact skiplist file");
+    }
+
+    nodes.release();
+    links.release();
+    probability = newProbability;
+    maxLevel = (size_type)header[1];
+    level = (size_type)header[2];
+    items = (size_type)header[3];
+    freeNodes = newFreeNodes;
+    freeLinks.swap(newFreeLinks);
+    update.assign(maxLevel+1, head);
+    try
+    {
+      nodes.read(file, (uint32_t)header[4]);
+      links.read(file, (uint32_t)header[5]);
+    }
+    catch(...)
+    {
+      fclose(file);
+      nodes.release();
+      links.release();
+      Init(probability, maxLevel);
+      throw;
+    }
+    fclose(file);
+  }
+
+private:
+  static const char* Magic() { return "CSCSKIP1"; }
+};
+
+template<class T, class A, unsigned int Bits>
+const uint32_t ChunkArena<T,A,Bits>::ChunkSize;
+
+template <class K, class T, class Pr, class R, class A>
+const typename CompactKeyedSkipList<K,T,Pr,R,A>::link_type CompactKeyedSkipList<K,T,Pr,R,A>::nil;
+
+template <class K, class T, class Pr, class R, class A>
+const typename CompactKeyedSkipList<K,T,Pr,R,A>::link_type CompactKeyedSkipList<K,T,Pr,R,A>::head;
+
+template <class K, class T, class Pr, class R, class A>
+bool operator==(const CompactKeyedSkipList<K,T,Pr,R,A> &left, const CompactKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+}
+
+template <class K, class T, class Pr, class R, class A>
+bool operator!=(const CompactKeyedSkipList<K,T,Pr,R,A> &left, const CompactKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return !(left==right);
+}
+
+}
+
+#endif
@@ -0,0 +1,600 @@
+/*
+   Description: Header file for DeterministicKeyedSkipList
+                1-2-3 skiplist that acts like a map, with worst case
+                O(log n) search, insert and erase.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSDeterministicSkipListH
+#define CSDeterministicSkipListH
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+#include "CSSkipListTools.h"
+
+namespace CS
+{
+
+// Links of the entry list every DeterministicKeyedSkipList keeps in order.
+struct EntryLinks
+{
+  EntryLinks *prev;
+  EntryLinks *next;
+};
+
+// Iterator over a DeterministicKeyedSkipList.  Walks the entry list, so it
+// stays valid until its own entry is erased.
+template<class Entry, class V>
+class EntryIterator : public std::iterator<std::bidirectional_iterator_tag, typename std::remove_const<V>::type, ptrdiff_t, V*, V&>
+{
+public:
+// WARNING:  DO NOT WRITE TO THE FOLLOWING MEMBERS!!!
+  EntryLinks *entry;
+
+  EntryIterator() : entry(NULL) {}
+  explicit EntryIterator(EntryLinks *entry) : entry(entry) {}
+  template<class V2> EntryIterator(const EntryIterator<Entry,V2> &right) : entry(right.entry) {}
+
+  V& operator*() const { return static_cast<Entry*>(entry)->object; }
+  V* operator->() const { return &**this; }
+
+  EntryIterator& operator++()
+  {
+    entry = entry->next;
+    return *this;
+  }
+
+  EntryIterator operator++(int)
+  {
+    EntryIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  EntryIterator& operator--()
+  {
+    entry = entry->prev;
+    return *this;
+  }
+
+  EntryIterator operator--(int)
+  {
+    EntryIterator old = *this;
+    --*this;
+    return old;
+  }
+
+  template<class V2> bool operator==(const EntryIterator<Entry,V2> &right) const { return entry==right.entry; }
+  template<class V2> bool operator!=(const EntryIterator<Entry,V2> &right) const { return entry!=right.entry; }
+};
+
+// Deterministic 1-2-3 skiplist after Munro, Papadakis and Sedgewick, in the
+// linked form of Weiss.  Every level is a list of nodes ending in a node with
+// an infinite key.  A node above level 1 covers a range of 2 to 4 nodes one
+// level down, starting at its down pointer and ending at the node with its
+// own key, so the list is shaped like a 2-3-4 tree.  insert() splits full
+// ranges and erase() fills thin ones on the way down, so neither backtracks,
+// and a search compares at most 4 keys per level.  No random levels means
+// no unlucky shapes: search, insert and erase are O(log n) in the worst case.
+//
+// Nodes refer to the entries, which never move and form a list of their own
+// for the iterators.  R is unused; it is kept so the container plugs in
+// wherever a KeyedSkipList does.
+template <class K, class T, class Pr, class R, class A>
+class DeterministicKeyedSkipList
+{
+public:
+  typedef DeterministicKeyedSkipList<K,T,Pr,R,A> container_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T& const_mapped_type_reference;
+  typedef Pr key_compare;
+
+  struct Entry : EntryLinks
+  {
+    value_type object;
+    explicit Entry(const value_type &val) : object(val) {}
+  };
+
+  typedef EntryIterator<Entry, value_type> iterator;
+  typedef EntryIterator<Entry, const value_type> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+
+private:
+  struct Node
+  {
+    Entry *entry; //!< Largest entry in the range below.  NULL is infinite.
+    Node *right;
+    Node *down; //!< First node of the range.  NULL on level 1.
+    Node(Entry *entry, Node *right, Node *down) : entry(entry), right(right), down(down) {}
+  };
+
+  typedef typename A::template rebind<Node>::other node_allocator;
+  typedef typename A::template rebind<Entry>::other entry_allocator;
+
+  key_compare KeyCompare;
+  Node *head; //!< Single infinite node on the top level.
+  mutable EntryLinks ends; //!< Sentinel of the entry list, end().
+  size_type items;
+  size_type height; //!< Levels below head.
+  std::vector<Node*, typename A::template rebind<Node*>::other> hits; //!< Nodes keyed by the entry erase() removes.
+
+  Node* NewNode(Entry *entry, Node *right, Node *down)
+  {
+    node_allocator alloc;
+    Node *node = alloc.allocate(1);
+    alloc.construct(node, entry, right, down);
+    return node;
+  }
+
+  void FreeNode(Node *node)
+  {
+    node_allocator alloc;
+    alloc.destroy(node);
+    alloc.deallocate(node, 1);
+  }
+
+  void Init()
+  {
+    ends.prev = ends.next = &ends;
+    items = 0;
+    height = 1;
+    head = NewNode(NULL, NULL, NewNode(NULL, NULL, NULL));
+  }
+
+  // node's key is below keyval.  The infinite key is below nothing.
+  bool Less(const Node *node, const key_type &keyval) const
+  {
+    return (node->entry!=NULL)&&(KeyCompare(node->entry->object.first,keyval));
+  }
+
+  bool Equal(const Node *node, const key_type &keyval) const
+  {
+    return (node->entry!=NULL)&&(!KeyCompare(keyval,node->entry->object.first));
+  }
+
+  // Nodes in the range below node, up to 4.
+  static size_type RangeSize(const Node *node)
+  {
+    size_type n = 1;
+    for(const Node *g=node->down;g->entry!=node->entry;g=g->right) n++;
+    return n;
+  }
+
+  // First level 1 node whose key is not below keyval.
+  Node* LowerNode(const key_type &keyval) const
+  {
+    Node *cursor = head;
+    for(;;)
+    {
+      while (Less(cursor, keyval)) cursor = cursor->right;
+      if (cursor->down==NULL) return cursor;
+      cursor = cursor->down;
+    }
+  }
+
+  // Makes sure the range below c has at least 3 nodes by borrowing a node
+  // from a sibling or merging with one.  left is the node before c in
+  // parent's range, NULL if c comes first.  Returns the node now covering
+  // c's range.
+  Node* Fill(Node *parent, Node *left, Node *c)
+  {
+    if (RangeSize(c)>=3) return c;
+    if (c->entry!=parent->entry)
+    {
+      Node *s = c->right;
+      if (RangeSize(s)>=3)
+      {
+        c->entry = s->down->entry;
+        s->down = s->down->right;
+      }
+      else
+      {
+        c->entry = s->entry;
+        c->right = s->right;
+        FreeNode(s);
+      }
+      return c;
+    }
+    if (left==NULL) return c; /* Only child of the head. */
+    if (RangeSize(left)>=3)
+    {
+      Node *g = left->down;
+      while (g->right->entry!=left->entry) g = g->right;
+      c->down = g->right;
+      left->entry = g->entry;
+      return c;
+    }
+    left->entry = c->entry;
+    left->right = c->right;
+    FreeNode(c);
+    return left;
+  }
+
+  // Drops top levels that cover a single node.
+  void LowerHead()
+  {
+    while ((height>1)&&(head->down->entry==NULL))
+    {
+      Node *old = head->down;
+      head->down = old->down;
+      FreeNode(old);
+      height--;
+    }
+  }
+
+  void LinkEntry(Entry *entry, EntryLinks *before)
+  {
+    entry->next = before;
+    entry->prev = before->prev;
+    before->prev->next = entry;
+    before->prev = entry;
+  }
+
+  void FreeEntry(Entry *entry)
+  {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry_allocator alloc;
+    alloc.destroy(entry);
+    alloc.deallocate(entry, 1);
+  }
+
+  void FreeAll()
+  {
+    for(Node *level=head;level!=NULL;)
+    {
+      Node *down = level->down;
+      while (level!=NULL)
+      {
+        Node *right = level->right;
+        FreeNode(level);
+        level = right;
+      }
+      level = down;
+    }
+    for(EntryLinks *e=ends.next;e!=&ends;)
+    {
+      EntryLinks *next = e->next;
+      entry_allocator alloc;
+      alloc.destroy(static_cast<Entry*>(e));
+      alloc.deallocate(static_cast<Entry*>(e), 1);
+      e = next;
+    }
+  }
+
+  template<class InIt> void CopyFrom(InIt first, InIt last)
+  {
+    for(InIt i=first;i!=last;++i) insert(*i);
+  }
+
+public:
+  DeterministicKeyedSkipList() : KeyCompare(Pr()) { Init(); }
+  explicit DeterministicKeyedSkipList(const key_compare& comp) : KeyCompare(comp) { Init(); }
+  DeterministicKeyedSkipList(const container_type &source) : KeyCompare(source.KeyCompare) { Init(); CopyFrom(source.begin(), source.end()); }
+  template<class InIt> DeterministicKeyedSkipList(InIt first, InIt last) : KeyCompare(Pr()) { Init(); CopyFrom(first, last); }
+  ~DeterministicKeyedSkipList() { FreeAll(); }
+
+  container_type& operator=(const container_type &source)
+  {
+    if (this==&source) return *this;
+    container_type temp(source);
+    swap(temp);
+    return *this;
+  }
+
+  iterator begin() { return iterator(ends.next); }
+  iterator end() { return iterator(&ends); }
+  const_iterator begin() const { return const_iterator(ends.next); }
+  const_iterator end() const { return const_iterator(&ends); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  size_type size() const { return items; }
+  bool empty() const { return items==0; }
+  size_type max_size() const { return entry_allocator().max_size(); }
+
+  slpair insert(const value_type &val)
+  {
+    const key_type &keyval = val.first;
+    Node *cursor = head;
+    for(;;)
+    {
+      while (Less(cursor, keyval)) cursor = cursor->right;
+      if (cursor->down==NULL) break;
+      if (RangeSize(cursor)==4)
+      {
+        /* Split the full range by raising its second node. */
+        Node *second = cursor->down->right;
+        cursor->right = NewNode(cursor->entry, cursor->right, second->right);
+        cursor->entry = second->entry;
+        if (cursor==head)
+        {
+          head = NewNode(NULL, NULL, head);
+          height++;
+        }
+        continue;
+      }
+      cursor = cursor->down;
+    }
+    if (Equal(cursor, keyval)) return slpair(iterator(cursor->entry), false);
+
+    entry_allocator alloc;
+    Entry *entry = alloc.allocate(1);
+    try
+    {
+      alloc.construct(entry, val);
+    }
+    catch(...)
+    {
+      alloc.deallocate(entry, 1);
+      throw;
+    }
+    /* The new node takes over cursor's entry, cursor takes the new one. */
+    try
+    {
+      cursor->right = NewNode(cursor->entry, cursor->right, NULL);
+    }
+    catch(...)
+    {
+      alloc.destroy(entry);
+      alloc.deallocate(entry, 1);
+      throw;
+    }
+    LinkEntry(entry, (cursor->entry!=NULL) ? static_cast<EntryLinks*>(cursor->entry) : &ends);
+    cursor->entry = entry;
+    items++;
+    return slpair(iterator(entry), true);
+  }
+
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; }
+  template<class InIt> void insert(InIt first, InIt last) { CopyFrom(first, last); }
+
+  size_type erase(const key_type &keyval)
+  {
+    LowerHead();
+    hits.clear();
+    Node *cursor = head;
+    for(;;)
+    {
+      Node *left = NULL;
+      Node *c = cursor->down;
+      while (Less(c, keyval))
+      {
+        left = c;
+        c = c->right;
+      }
+      if (c->down==NULL) break;
+      c = Fill(cursor, left, c);
+      if (Equal(c, keyval)) hits.push_back(c);
+      cursor = c;
+    }
+
+    /* cursor is on level 2; find the level 1 node in its range. */
+    Node *left = NULL;
+    Node *d = cursor->down;
+    while (Less(d, keyval))
+    {
+      left = d;
+      d = d->right;
+    }
+    if (!Equal(d, keyval))
+    {
+      LowerHead();
+      return 0;
+    }
+
+    Entry *entry = d->entry;
+    if (d->entry!=cursor->entry)
+    {
+      /* Pull the next node of the range into d. */
+      Node *next = d->right;
+      d->entry = next->entry;
+      d->right = next->right;
+      FreeNode(next);
+    }
+    else
+    {
+      /* d ends the range, so its key is on the nodes above too.  Fill() */
+      /* left at least 3 nodes in the range, so d has a predecessor. */
+      left->right = d->right;
+      FreeNode(d);
+      for(size_type i=0;i<hits.size();i++) hits[i]->entry = left->entry;
+    }
+    FreeEntry(entry);
+    items--;
+    LowerHead();
+    return 1;
+  }
+
+  iterator erase(const iterator &where)
+  {
+    if (where.entry==&ends) return end();
+    EntryLinks *next = where.entry->next;
+    erase(static_cast<Entry*>(where.entry)->object.first);
+    return iterator(next);
+  }
+
+  iterator erase(iterator first, const iterator &last)
+  {
+    while (first!=last) first = erase(first);
+    return first;
+  }
+
+  void clear()
+  {
+    FreeAll();
+    Init();
+  }
+
+  void swap(container_type &right)
+  {
+    std::swap(KeyCompare, right.KeyCompare);
+    std::swap(head, right.head);
+    std::swap(items, right.items);
+    std::swap(height, right.height);
+    /* The sentinels stay put, so relink the lists to them. */
+    std::swap(ends, right.ends);
+    if (ends.next==&right.ends) ends.next = ends.prev = &ends;
+    else ends.next->prev = ends.prev->next = &ends;
+    if (right.ends.next==&ends) right.ends.next = right.ends.prev = &right.ends;
+    else right.ends.next->prev = right.ends.prev->next = &right.ends;
+  }
+
+  mapped_type_reference operator[](const key_type& key)
+  {
+    return insert(value_type(key, mapped_type())).first->second;
+  }
+
+  key_compare key_comp() const { return KeyCompare; }
+
+  iterator find(const key_type &keyval)
+  {
+    Node *node = LowerNode(keyval);
+    return Equal(node, keyval) ? iterator(node->entry) : end();
+  }
+
+  const_iterator find(const key_type &keyval) const
+  {
+    Node *node = LowerNode(keyval);
+    return Equal(node, keyval) ? const_iterator(node->entry) : end();
+  }
+
+  size_type count(const key_type &keyval) const { return Equal(LowerNode(keyval), keyval) ? 1 : 0; }
+
+  iterator lower_bound(const key_type &keyval)
+  {
+    Node *node = LowerNode(keyval);
+    return (node->entry!=NULL) ? iterator(node->entry) : end();
+  }
+
+  const_iterator lower_bound(const key_type &keyval) const
+  {
+    Node *node = LowerNode(keyval);
+    return (node->entry!=NULL) ? const_iterator(node->entry) : end();
+  }
+
+  iterator upper_bound(const key_type &keyval)
+  {
+    iterator i = lower_bound(keyval);
+    if ((i!=end())&&(!KeyCompare(keyval,i->first))) ++i;
+    return i;
+  }
+
+  const_iterator upper_bound(const key_type &keyval) const
+  {
+    const_iterator i = lower_bound(keyval);
+    if ((i!=end())&&(!KeyCompare(keyval,i->first))) ++i;
+    return i;
+  }
+
+  ipair equal_range(const key_type &keyval) { return ipair(lower_bound(keyval), upper_bound(keyval)); }
+  const_ipair equal_range(const key_type &keyval) const { return const_ipair(lower_bound(keyval), upper_bound(keyval)); }
+
+  // A key's level is the highest level with a node for it.  Node bytes
+  // count the entries and every node, the infinite ones included.
+  SkipListStats stats(size_type samples = 1024) const
+  {
+    SkipListStats s;
+    s.items = items;
+    s.level = (unsigned int)(height-1);
+    s.maxLevel = s.level;
+    s.nodesPerLevel.assign(height, 0);
+    s.sampled = 0;
+    s.maxPath = 0;
+    s.nodeBytes = items*sizeof(Entry);
+    s.pointerBytes = items*2*sizeof(EntryLinks*);
+
+    /* Keys per level, top down; the difference between levels gives the */
+    /* keys whose highest level that is. */
+    std::vector<size_type> keys(height, 0);
+    size_type h = height;
+    for(const Node *level=head->down;level!=NULL;level=level->down)
+    {
+      h--;
+      for(const Node *node=level;node!=NULL;node=node->right)
+      {
+        if (node->entry!=NULL) keys[h]++;
+        s.nodeBytes += sizeof(Node);
+        s.pointerBytes += 3*sizeof(Node*);
+      }
+    }
+    for(size_type i=0;i<height;i++) s.nodesPerLevel[i] = keys[i]-((i+1<height) ? keys[i+1] : 0);
+
+    size_type stride = (samples==0) ? 0 : (items+samples-1)/samples;
+    size_type pos = 0;
+    size_type totalPath = 0;
+    for(const EntryLinks *e=ends.next;e!=&ends;e=e->next,pos++)
+    {
+      if ((stride==0)||(pos%stride!=0)) continue;
+      const key_type &keyval = static_cast<const Entry*>(e)->object.first;
+      /* One step per drop to a lower level and one per link followed. */
+      size_type path = 0;
+      const Node *cursor = head;
+      for(;;)
+      {
+        while (Less(cursor, keyval))
+        {
+          cursor = cursor->right;
+          path++;
+        }
+        if (cursor->down==NULL) break;
+        cursor = cursor->down;
+        path++;
+      }
+      totalPath += path;
+      if (path>s.maxPath) s.maxPath = path;
+      s.sampled++;
+    }
+    s.averagePath = (s.sampled==0) ? 0.0 : (double)totalPath/(double)s.sampled;
+    s.sentinelBytes = (height+1)*sizeof(Node)+sizeof(ends);
+    s.updateBytes = 0;
+    s.filterBytes = 0;
+    s.deadNodes = 0;
+    return s;
+  }
+};
+
+template <class K, class T, class Pr, class R, class A>
+bool operator==(const DeterministicKeyedSkipList<K,T,Pr,R,A> &left, const DeterministicKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+}
+
+template <class K, class T, class Pr, class R, class A>
+bool operator!=(const DeterministicKeyedSkipList<K,T,Pr,R,A> &left, const DeterministicKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return !(left==right);
+}
+
+}
+
+#endif
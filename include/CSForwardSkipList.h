@@ -0,0 +1,218 @@
+/*
+   Description: Header file for ForwardKeyedSkipList
+                Singly linked skiplist that acts like a map.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSForwardSkipListH
+#define CSForwardSkipListH
+
+#include <utility>
+#include <iterator>
+#include <functional>
+#include "CSSkipListTools.h"
+#include "CSIterators.h"
+#include "CSBloomFilter.h"
+
+namespace CS
+{
+#define CSBIDI(a,b) b
+#define CSUNIQUE(a,b) a
+#define CSINDEX(a,b) b
+#define CSKEY(a,b) a
+#define CSLEVEL(a,b) a
+#define CSFILTER(a,b) a
+#define CSLAZY(a,b) a
+#define CSSTATIC(a,b) b
+#define CSADAPT(a,b) b
+
+// KeyedSkipList on ForwardNodes, which keep no backward pointers.  Nodes are
+// smaller and insert and erase relink half as many pointers.  Erasing by
+// iterator, operator-- and the lazy erase cleanup search from the head
+// instead of following a backward link.
+template <class K, class T, class Pr, class R, class A>
+class ForwardKeyedSkipList
+{
+public:
+  typedef CSUNIQUE(CSKEY(uniquekey_tag,unique_tag),CSKEY(multikey_tag,multi_tag)) tag;
+  typedef ForwardKeyedSkipList<K,T,Pr,R,A> container_type;
+  typedef ForwardIterator<container_type> T0;
+  typedef ConstForwardIterator<container_type> T1;
+  friend class ForwardIterator<container_type>;
+  friend class ConstForwardIterator<container_type>;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef ForwardNode<value_type> node_type;
+  typedef T0 iterator;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T const_mapped_type;
+  typedef const T& const_mapped_type_reference;
+  typedef const value_type& const_reference;
+  typedef T1 const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+  typedef Pr key_compare;
+  typedef KeyOrder<Pr, K> key_order;
+  typedef GeometricLevels level_generator;
+  typedef CountingBloomFilter<K,std::hash<K>,A> filter_type;
+
+  class value_compare
+    : public std::binary_function<value_type, value_type, bool>
+  {
+  friend class ForwardKeyedSkipList<K,T,Pr,R,A>;
+  public:
+    bool operator()(const value_type& left, const value_type& right) const
+      {return (comp(left.first, right.first)); }
+  protected:
+    value_compare(const key_compare &pr) : comp(pr) {}
+    key_compare comp;
+  };
+
+private:
+  R rng;
+  key_compare KeyCompare;
+  value_compare ValueCompare;
+  size_type maxLevel; //!< Maximum number of forward pointers possible, at most 255.
+  size_type level;    //!< The maximum number of forward pointers on any given container currently in use.
+  node_type *head,*tail; //!< Start and end containers.
+  double probability; //!< Probability to go to the next level.
+  size_type items; //!< Number of items in the list.
+  mutable std::pair<size_type,node_type*> *update;
+  filter_type *bloom; //!< Optional membership filter.  NULL when disabled.
+  bool lazy; //!< erase() marks nodes dead instead of freeing them.
+  size_type tombstones; //!< Number of dead nodes still linked.
+  std::vector<node_type*, typename A::template rebind<node_type*>::other> graveyard; //!< Dead nodes waiting for compact().
+  CSDefineInit
+  node_type* Alloc(size_type level, const value_type &obj) CSAlloc2(A, level,obj,node_type)
+  node_type* Alloc(size_type level) CSAlloc(A, level,node_type)
+  void Free(node_type *item) CSFree(A, item,node_type)
+  CSDefineGenerateRandomLevel
+  CSDefineAdjustLevels
+  CSDefineScanKey
+  CSDefineScanVal
+  CSDefineScanIterator
+  CSDefineScanNode
+  CSDefineLazyNodes
+public:
+
+  CheckSkipNodes
+  CSDefineStats
+
+  ForwardKeyedSkipList() : ValueCompare(Pr()) { CSInitDefault; }
+  explicit ForwardKeyedSkipList(size_type maxNodes) : ValueCompare(Pr()) { CSInitMaxNodes; }
+  ForwardKeyedSkipList(double probability, size_type maxLevel) : ValueCompare(Pr()) { CSInitPM; }
+  ForwardKeyedSkipList(const container_type &source) : ValueCompare(source.ValueCompare), KeyCompare(source.KeyCompare) { CSInitCore(source.probability, source.maxLevel) if (source.bloom!=NULL) enable_filter(source.bloom->expected_items(),source.bloom->target_rate()); CSCopyITIT(const_iterator, source.begin(),source.end(),insert); lazy = source.lazy; }
+  template<class InIt> ForwardKeyedSkipList(InIt first, InIt last) : ValueCompare(Pr()) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> ForwardKeyedSkipList(InIt first, InIt last, double probability, size_type maxLevel) : ValueCompare(Pr()) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> ForwardKeyedSkipList(InIt first, InIt last, size_type maxNodes) : ValueCompare(Pr()) { CSInitMaxNodes; CSCopyITIT(InIt, first,last,insert); }
+  explicit ForwardKeyedSkipList(const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitDefault; }
+  template<class InIt> ForwardKeyedSkipList(InIt first, InIt last, const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> ForwardKeyedSkipList(InIt first, InIt last, const key_compare& comp, double probability, size_type maxLevel) : ValueCompare(comp), KeyCompare(comp) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
+  template<class InIt> ForwardKeyedSkipList(InIt first, InIt last, const key_compare& comp, size_type maxNodes) : ValueCompare(comp), KeyCompare(comp) { CSInitMaxNodes; CSCopyITIT(InIt, first,last,insert); }
+  ~ForwardKeyedSkipList() { clear(); delete bloom; }
+  CSDefineOperatorEqual
+
+  CSDefineBeginEnd
+  CSDefineRBeginEnd
+  CSDefineSize
+  CSDefineEmpty
+  CSDefineFront
+  CSDefineBackForward
+  CSDefinePopFront
+  CSDefinePopBackForward
+  CSDefineAssignITIT(insert)
+
+  CSDefineInsertVal
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; } // Don't use this.  Calls insert(const value_type& type);
+  template<class InIt> void insert(InIt first, InIt last) { CSCopyITIT(InIt, first, last, insert); }
+
+  CSDefineErase
+  CSDefineEraseITIT
+  CSDefineEraseKey
+
+  CSDefineClear
+  CSDefineDestroy
+  void swap(container_type& right) { CSSwapCore std::swap(ValueCompare, right.ValueCompare); std::swap(KeyCompare, right.KeyCompare); }
+  CSDefineEraseIf
+  CSDefineDestroyIf
+
+  CSDefineCut
+  CSDefineFilter
+  CSDefineSplit
+  CSDefineAssignSorted
+  CSDefineInsertBatch
+  CSDefineLazy
+  CSDefineRebalance
+  CSDefineOperatorArrayMap
+  CSDefineOperatorArrayMap2
+
+  CSDefineKeyCompare(KeyCompare)
+  CSDefineValueCompare(ValueCompare)
+  CSDefineMaxSize
+
+  const key_type& key(const_reference value) const {return value.first;}
+  mapped_type_reference value(reference value) const {return value.second;}
+  const_mapped_type_reference value(const_reference value) const {return value.second;}
+  CSDefineFind
+  CSDefineFindSteps
+  CSDefineCount
+  CSDefineLowerBound
+  CSDefineUpperBound
+  CSDefineEqualRange
+  CSDefinePrefix
+};
+
+template <class K, class T, class Pr, class R, class A>
+bool operator==(const ForwardKeyedSkipList<K,T,Pr,R,A> &left, const ForwardKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+
+}
+
+template <class K, class T, class Pr, class R, class A>
+bool operator<(const ForwardKeyedSkipList<K,T,Pr,R,A> &left, const ForwardKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return lexicographical_compare(left.begin(),left.end(),right.begin(),right.end(),left.value_comp());
+}
+
+#define csarg1 template<class K, class T, class Pr, class R, class A>
+#define csarg2 ForwardKeyedSkipList<K,T,Pr,R,A>
+CSDefineCompOps(csarg1, csarg2)
+#undef csarg1
+#undef csarg2
+
+#undef CSFILTER
+#undef CSLAZY
+#undef CSADAPT
+#undef CSSTATIC
+#undef CSKEY
+#undef CSINDEX
+#undef CSUNIQUE
+#undef CSBIDI
+#undef CSLEVEL
+
+}
+
+
+#endif
+
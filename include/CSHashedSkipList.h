@@ -0,0 +1,279 @@
+/*
+   Description: Header file for HashedKeyedSkipList
+                KeyedSkipList with an open addressing table from key
+                fingerprints to nodes for constant time point lookups.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSHashedSkipListH
+#define CSHashedSkipListH
+
+#include <utility>
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include "CSKeyedSkipList.h"
+
+namespace CS
+{
+
+// Map that keeps its entries in a KeyedSkipList and indexes the nodes in a
+// linear probing table of 32 bit fingerprints and node pointers, 12 bytes a
+// slot on 64 bit targets.  find(), count() and contains() go through the
+// table and compare the key only when the fingerprint matches.  Everything
+// ordered (iteration, lower_bound(), ranges) is the list's.  Both are
+// updated by every insert and erase, and the table grows by doubling once
+// it is three quarters full.  H must agree with Pr: keys that compare
+// equivalent must hash alike.
+template <class K, class T, class Pr, class R, class A, class H = std::hash<K> >
+class HashedKeyedSkipList
+{
+public:
+  typedef HashedKeyedSkipList<K,T,Pr,R,A,H> container_type;
+  typedef KeyedSkipList<K,T,Pr,R,A> list_type;
+  typedef typename list_type::size_type size_type;
+  typedef typename list_type::difference_type difference_type;
+  typedef typename list_type::key_type key_type;
+  typedef typename list_type::value_type value_type;
+  typedef typename list_type::pointer pointer;
+  typedef typename list_type::reference reference;
+  typedef typename list_type::const_reference const_reference;
+  typedef typename list_type::data_type data_type;
+  typedef typename list_type::mapped_type mapped_type;
+  typedef typename list_type::mapped_type_reference mapped_type_reference;
+  typedef typename list_type::const_mapped_type_reference const_mapped_type_reference;
+  typedef typename list_type::iterator iterator;
+  typedef typename list_type::const_iterator const_iterator;
+  typedef typename list_type::reverse_iterator reverse_iterator;
+  typedef typename list_type::const_reverse_iterator const_reverse_iterator;
+  typedef typename list_type::slpair slpair;
+  typedef typename list_type::ipair ipair;
+  typedef typename list_type::const_ipair const_ipair;
+  typedef typename list_type::key_compare key_compare;
+  typedef typename list_type::value_compare value_compare;
+  typedef H hasher;
+
+private:
+  typedef typename list_type::node_type node_type;
+  typedef typename list_type::key_order key_order;
+  typedef typename A::template rebind<uint32_t>::other fingerprint_allocator;
+  typedef typename A::template rebind<node_type*>::other slot_allocator;
+
+  list_type list;
+  std::vector<uint32_t, fingerprint_allocator> fingerprints; //!< 0 marks an empty slot.
+  std::vector<node_type*, slot_allocator> nodes; //!< Node of every used slot.
+  size_type mask; //!< Slots-1.  The slot count is a power of two, or 0.
+
+  // std::hash is the identity for integers, so the result goes through the
+  // same 64 bit finalizer as CountingBloomFilter.  The low half picks the
+  // slot and the high half is the fingerprint.
+  static unsigned long long Hash(const key_type &keyval)
+  {
+    unsigned long long x = (unsigned long long)hasher()(keyval);
+    x ^= x>>33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x>>33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x>>33;
+    return x;
+  }
+
+  static uint32_t Fingerprint(unsigned long long x) { return (uint32_t)(x>>32)|1; }
+
+  node_type* Lookup(const key_type &keyval, unsigned long long x) const
+  {
+    if (nodes.empty()) return NULL;
+    uint32_t fingerprint = Fingerprint(x);
+    for(size_type i=(size_type)x&mask;fingerprints[i]!=0;i=(i+1)&mask)
+    {
+      if ((fingerprints[i]==fingerprint)&&(key_order::equal(list.key_comp(),nodes[i]->object.first,keyval))) return nodes[i];
+    }
+    return NULL;
+  }
+
+  void Place(node_type *node, unsigned long long x)
+  {
+    size_type i = (size_type)x&mask;
+    while (fingerprints[i]!=0) i = (i+1)&mask;
+    fingerprints[i] = Fingerprint(x);
+    nodes[i] = node;
+  }
+
+  // Empties the slot of node and moves later entries of its probe run back
+  // into the hole, so lookups never need tombstones.
+  void Unlink(const node_type *node)
+  {
+    size_type i = (size_type)Hash(node->object.first)&mask;
+    while (nodes[i]!=node) i = (i+1)&mask;
+    for(size_type j=(i+1)&mask;fingerprints[j]!=0;j=(j+1)&mask)
+    {
+      size_type home = (size_type)Hash(nodes[j]->object.first)&mask;
+      if (((j-home)&mask)>=((j-i)&mask))
+      {
+        fingerprints[i] = fingerprints[j];
+        nodes[i] = nodes[j];
+        i = j;
+      }
+    }
+    fingerprints[i] = 0;
+    nodes[i] = NULL;
+  }
+
+  void Rehash(size_type slots)
+  {
+    std::vector<uint32_t, fingerprint_allocator> newFingerprints(slots, 0);
+    std::vector<node_type*, slot_allocator> newNodes(slots, (node_type*)NULL);
+    fingerprints.swap(newFingerprints);
+    nodes.swap(newNodes);
+    mask = slots-1;
+    for(iterator i=list.begin();i!=list.end();++i) Place(i.node, Hash(i->first));
+  }
+
+  // Makes room for one more entry.
+  void Reserve()
+  {
+    if ((list.size()+1)*4<=nodes.size()*3) return;
+    Rehash(nodes.empty() ? 16 : nodes.size()*2);
+  }
+
+public:
+  HashedKeyedSkipList() : mask(0) {}
+  explicit HashedKeyedSkipList(const key_compare& comp) : list(comp), mask(0) {}
+  HashedKeyedSkipList(const container_type &source) : list(source.list), mask(0) { if (!source.nodes.empty()) Rehash(source.nodes.size()); }
+  template<class InIt> HashedKeyedSkipList(InIt first, InIt last) : mask(0) { insert(first, last); }
+
+  container_type& operator=(const container_type &source)
+  {
+    if (this==&source) return *this;
+    container_type temp(source);
+    swap(temp);
+    return *this;
+  }
+
+  iterator begin() { return list.begin(); }
+  iterator end() { return list.end(); }
+  const_iterator begin() const { return list.begin(); }
+  const_iterator end() const { return list.end(); }
+  reverse_iterator rbegin() { return list.rbegin(); }
+  reverse_iterator rend() { return list.rend(); }
+  const_reverse_iterator rbegin() const { return list.rbegin(); }
+  const_reverse_iterator rend() const { return list.rend(); }
+
+  size_type size() const { return list.size(); }
+  bool empty() const { return list.empty(); }
+  size_type max_size() const { return list.max_size(); }
+
+  slpair insert(const value_type &val)
+  {
+    unsigned long long x = Hash(val.first);
+    node_type *node = Lookup(val.first, x);
+    if (node!=NULL) return slpair(iterator(&list,node), false);
+    Reserve();
+    slpair result = list.insert(val);
+    Place(result.first.node, x);
+    return result;
+  }
+
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; }
+  template<class InIt> void insert(InIt first, InIt last) { for(InIt i=first;i!=last;++i) insert(*i); }
+
+  iterator erase(const iterator &where)
+  {
+    if (where==end()) return where;
+    Unlink(where.node);
+    return list.erase(where);
+  }
+
+  iterator erase(const iterator &first, const iterator &last)
+  {
+    for(iterator i=first;i!=last;++i) Unlink(i.node);
+    return list.erase(first, last);
+  }
+
+  size_type erase(const key_type &keyval)
+  {
+    node_type *node = Lookup(keyval, Hash(keyval));
+    if (node==NULL) return 0;
+    Unlink(node);
+    list.erase(iterator(&list,node));
+    return 1;
+  }
+
+  void clear()
+  {
+    list.clear();
+    std::vector<uint32_t, fingerprint_allocator>().swap(fingerprints);
+    std::vector<node_type*, slot_allocator>().swap(nodes);
+    mask = 0;
+  }
+
+  void swap(container_type &right)
+  {
+    list.swap(right.list);
+    fingerprints.swap(right.fingerprints);
+    nodes.swap(right.nodes);
+    std::swap(mask, right.mask);
+  }
+
+  mapped_type_reference operator[](const key_type& key)
+  {
+    return insert(value_type(key, mapped_type())).first->second;
+  }
+
+  key_compare key_comp() const { return list.key_comp(); }
+  value_compare value_comp() const { return list.value_comp(); }
+
+  iterator find(const key_type &keyval)
+  {
+    node_type *node = Lookup(keyval, Hash(keyval));
+    return (node!=NULL) ? iterator(&list,node) : end();
+  }
+
+  const_iterator find(const key_type &keyval) const
+  {
+    node_type *node = Lookup(keyval, Hash(keyval));
+    return (node!=NULL) ? const_iterator(&list,node) : end();
+  }
+
+  bool contains(const key_type &keyval) const { return Lookup(keyval, Hash(keyval))!=NULL; }
+  size_type count(const key_type &keyval) const { return contains(keyval) ? 1 : 0; }
+
+  iterator lower_bound(const key_type &keyval) { return list.lower_bound(keyval); }
+  const_iterator lower_bound(const key_type &keyval) const { return list.lower_bound(keyval); }
+  iterator upper_bound(const key_type &keyval) { return list.upper_bound(keyval); }
+  const_iterator upper_bound(const key_type &keyval) const { return list.upper_bound(keyval); }
+  ipair equal_range(const key_type &keyval) { return list.equal_range(keyval); }
+  const_ipair equal_range(const key_type &keyval) const { return list.equal_range(keyval); }
+
+  SkipListStats stats(size_type samples = 1024) const { return list.stats(samples); }
+
+  // Bytes held by the table, which the list's stats() do not count.
+  size_type index_bytes() const { return nodes.size()*(sizeof(uint32_t)+sizeof(node_type*)); }
+};
+
+template <class K, class T, class Pr, class R, class A, class H>
+bool operator==(const HashedKeyedSkipList<K,T,Pr,R,A,H> &left, const HashedKeyedSkipList<K,T,Pr,R,A,H> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+}
+
+template <class K, class T, class Pr, class R, class A, class H>
+bool operator!=(const HashedKeyedSkipList<K,T,Pr,R,A,H> &left, const HashedKeyedSkipList<K,T,Pr,R,A,H> &right)
+{
+  return !(left==right);
+}
+
+}
+
+#endif
@@ -33,7 +33,9 @@ class unique_tag {};         // Cannot happen
 #define CSDefineIteratorDecForward2(it) \
   it& operator--() \
   { \
-    return dec(tag()); \
+    dec(tag()); \
+CSLAZY(while ((node->state&node_dead)&&(node!=container->head->forward(0))) dec(tag());,) \
+    return *this; \
   } \
  \
   CSDefineIteratorDecPost(it) \
@@ -211,6 +213,7 @@ CSINDEX(return (Findex<other.Findex);,) \
 #define CSLEVEL(a,b) a
 #define CSBIDI(a,b) a
 #define CSINDEX(a,b) a
+#define CSLAZY(a,b) b
 
 // BidiIdxIterator
 template<class container_type>
@@ -473,6 +476,8 @@ public:
 #undef CSINDEX
 #define CSBIDI(a,b) a
 #define CSINDEX(a,b) b
+#undef CSLAZY
+#define CSLAZY(a,b) a
 
 // Bidi Iterator
 template<class container_type>
@@ -574,6 +579,8 @@ public:
 #undef CSINDEX
 #define CSBIDI(a,b) b
 #define CSINDEX(a,b) b
+#undef CSLAZY
+#define CSLAZY(a,b) a
 
 // Forward Iterator
 template<class container_type>
@@ -807,5 +814,6 @@ public:
 #undef CSBIDI
 #undef CSINDEX
 #undef CSLEVEL
+#undef CSLAZY
 }
 #endif
@@ -22,8 +22,11 @@
 #include <utility>
 #include <iterator>
 #include <functional>
+#include <list>
+#include <type_traits>
 #include "CSSkipListTools.h"
 #include "CSIterators.h"
+#include "CSBloomFilter.h"
 
 namespace CS
 {
@@ -32,13 +35,17 @@ namespace CS
 #define CSINDEX(a,b) b
 #define CSKEY(a,b) a
 #define CSLEVEL(a,b) a
+#define CSFILTER(a,b) a
+#define CSLAZY(a,b) a
+#define CSSTATIC(a,b) b
+#define CSADAPT(a,b) b
 
-template <class K, class T, class Pr, class R, class A>
+template <class K, class T, class Pr, class R, class A, class Policy = SkipListPolicy<K,Pr> >
 class KeyedSkipList
 {
 public:
   typedef CSUNIQUE(CSKEY(uniquekey_tag,unique_tag),CSKEY(multikey_tag,multi_tag)) tag;
-  typedef KeyedSkipList<K,T,Pr,R,A> container_type;
+  typedef KeyedSkipList<K,T,Pr,R,A,Policy> container_type;
   typedef BidiIterator<container_type> T0;
   typedef ConstBidiIterator<container_type> T1;
   friend class BidiIterator<container_type>;
@@ -64,11 +71,14 @@ public:
   typedef std::pair<iterator, iterator> ipair;
   typedef std::pair<const_iterator, const_iterator> const_ipair;
   typedef Pr key_compare;
+  typedef typename Policy::key_order key_order;
+  typedef typename Policy::level_generator level_generator;
+  typedef CountingBloomFilter<K,std::hash<K>,A> filter_type;
 
   class value_compare
     : public std::binary_function<value_type, value_type, bool>
   {
-  friend class KeyedSkipList<K,T,Pr,R,A>;
+  friend class KeyedSkipList<K,T,Pr,R,A,Policy>;
   public:
     bool operator()(const value_type& left, const value_type& right) const
       {return (comp(left.first, right.first)); }
@@ -81,12 +91,16 @@ private:
   R rng;
   key_compare KeyCompare;
   value_compare ValueCompare;
-  size_type maxLevel; //!< Maximum number of forward pointers possible.
+  size_type maxLevel; //!< Maximum number of forward pointers possible, at most 255.
   size_type level;    //!< The maximum number of forward pointers on any given container currently in use.
   node_type *head,*tail; //!< Start and end containers.
   double probability; //!< Probability to go to the next level.
   size_type items; //!< Number of items in the list.
   mutable std::pair<size_type,node_type*> *update;
+  filter_type *bloom; //!< Optional membership filter.  NULL when disabled.
+  bool lazy; //!< erase() marks nodes dead instead of freeing them.
+  size_type tombstones; //!< Number of dead nodes still linked.
+  std::vector<node_type*, typename A::template rebind<node_type*>::other> graveyard; //!< Dead nodes waiting for compact().
   CSDefineInit
   node_type* Alloc(size_type level, const value_type &obj) CSAlloc2(A, level,obj,node_type)
   node_type* Alloc(size_type level) CSAlloc(A, level,node_type)
@@ -97,14 +111,17 @@ private:
   CSDefineScanVal
   CSDefineScanIterator
   CSDefineScanNode
+  CSDefineScanBack
+  CSDefineLazyNodes
 public:
 
   CheckSkipNodes
+  CSDefineStats
 
   KeyedSkipList() : ValueCompare(Pr()) { CSInitDefault; }
   explicit KeyedSkipList(size_type maxNodes) : ValueCompare(Pr()) { CSInitMaxNodes; }
   KeyedSkipList(double probability, size_type maxLevel) : ValueCompare(Pr()) { CSInitPM; }
-  KeyedSkipList(const container_type &source) : ValueCompare(source.ValueCompare), KeyCompare(source.KeyCompare) { CSInitCore(source.probability, source.maxLevel) CSCopyITIT(const_iterator, source.begin(),source.end(),insert); }
+  KeyedSkipList(const container_type &source) : ValueCompare(source.ValueCompare), KeyCompare(source.KeyCompare) { CSInitCore(source.probability, source.maxLevel) if (source.bloom!=NULL) enable_filter(source.bloom->expected_items(),source.bloom->target_rate()); CSCopyITIT(const_iterator, source.begin(),source.end(),insert); lazy = source.lazy; }
   template<class InIt> KeyedSkipList(InIt first, InIt last) : ValueCompare(Pr()) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
   template<class InIt> KeyedSkipList(InIt first, InIt last, double probability, size_type maxLevel) : ValueCompare(Pr()) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
   template<class InIt> KeyedSkipList(InIt first, InIt last, size_type maxNodes) : ValueCompare(Pr()) { CSInitMaxNodes; CSCopyITIT(InIt, first,last,insert); }
@@ -112,7 +129,7 @@ public:
   template<class InIt> KeyedSkipList(InIt first, InIt last, const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
   template<class InIt> KeyedSkipList(InIt first, InIt last, const key_compare& comp, double probability, size_type maxLevel) : ValueCompare(comp), KeyCompare(comp) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
   template<class InIt> KeyedSkipList(InIt first, InIt last, const key_compare& comp, size_type maxNodes) : ValueCompare(comp), KeyCompare(comp) { CSInitMaxNodes; CSCopyITIT(InIt, first,last,insert); }
-  ~KeyedSkipList() { clear(); }
+  ~KeyedSkipList() { clear(); delete bloom; }
   CSDefineOperatorEqual
 
   CSDefineBeginEnd
@@ -140,6 +157,12 @@ public:
   CSDefineDestroyIf
 
   CSDefineCut
+  CSDefineFilter
+  CSDefineSplit
+  CSDefineAssignSorted
+  CSDefineInsertBatch
+  CSDefineLazy
+  CSDefineRebalance
   CSDefineOperatorArrayMap
   CSDefineOperatorArrayMap2
 
@@ -151,32 +174,299 @@ public:
   mapped_type_reference value(reference value) const {return value.second;}
   const_mapped_type_reference value(const_reference value) const {return value.second;}
   CSDefineFind
+  CSDefineFindSteps
   CSDefineCount
   CSDefineLowerBound
   CSDefineUpperBound
   CSDefineEqualRange
+  CSDefinePrefix
 };
 
-template <class K, class T, class Pr, class R, class A>
-bool operator==(const KeyedSkipList<K,T,Pr,R,A> &left, const KeyedSkipList<K,T,Pr,R,A> &right)
+template <class K, class T, class Pr, class R, class A, class Policy>
+bool operator==(const KeyedSkipList<K,T,Pr,R,A,Policy> &left, const KeyedSkipList<K,T,Pr,R,A,Policy> &right)
 {
   return ((left.size() == right.size()) &&
           (std::equal(left.begin(), left.end(), right.begin())));
 
 }
 
-template <class K, class T, class Pr, class R, class A>
-bool operator<(const KeyedSkipList<K,T,Pr,R,A> &left, const KeyedSkipList<K,T,Pr,R,A> &right)
+template <class K, class T, class Pr, class R, class A, class Policy>
+bool operator<(const KeyedSkipList<K,T,Pr,R,A,Policy> &left, const KeyedSkipList<K,T,Pr,R,A,Policy> &right)
 {
   return lexicographical_compare(left.begin(),left.end(),right.begin(),right.end(),left.value_comp());
 }
 
-#define csarg1 template<class K, class T, class Pr, class R, class A>
-#define csarg2 KeyedSkipList<K,T,Pr,R,A>
+#define csarg1 template<class K, class T, class Pr, class R, class A, class Policy>
+#define csarg2 KeyedSkipList<K,T,Pr,R,A,Policy>
 CSDefineCompOps(csarg1, csarg2)
 #undef csarg1
 #undef csarg2
 
+// Iterator over a MultiKeyedSkipList.  outer is the group of the current
+// key and inner the entry within it.  At the end outer equals last and inner
+// is singular.
+template<class V, class OuterIt, class InnerIt>
+class GroupIterator : public std::iterator<std::bidirectional_iterator_tag, typename std::remove_const<V>::type, ptrdiff_t, V*, V&>
+{
+public:
+// WARNING:  DO NOT WRITE TO THE FOLLOWING MEMBERS!!!
+  OuterIt outer;
+  OuterIt last;
+  InnerIt inner;
+
+  GroupIterator() {}
+  GroupIterator(const OuterIt &outer, const OuterIt &last, const InnerIt &inner) : outer(outer), last(last), inner(inner) {}
+  template<class V2, class OuterIt2, class InnerIt2> GroupIterator(const GroupIterator<V2,OuterIt2,InnerIt2> &right) : outer(right.outer), last(right.last), inner(right.inner) {}
+
+  V& operator*() const { return *inner; }
+  V* operator->() const { return &*inner; }
+
+  GroupIterator& operator++()
+  {
+    if (++inner==outer->second.end())
+    {
+      ++outer;
+      inner = (outer==last) ? InnerIt() : InnerIt(outer->second.begin());
+    }
+    return *this;
+  }
+
+  GroupIterator operator++(int)
+  {
+    GroupIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  GroupIterator& operator--()
+  {
+    if ((outer==last)||(inner==outer->second.begin()))
+    {
+      --outer;
+      inner = outer->second.end();
+    }
+    --inner;
+    return *this;
+  }
+
+  GroupIterator operator--(int)
+  {
+    GroupIterator old = *this;
+    --*this;
+    return old;
+  }
+
+  template<class V2, class OuterIt2, class InnerIt2> bool operator==(const GroupIterator<V2,OuterIt2,InnerIt2> &right) const
+  {
+    return (outer==right.outer)&&((outer==last)||(inner==right.inner));
+  }
+
+  template<class V2, class OuterIt2, class InnerIt2> bool operator!=(const GroupIterator<V2,OuterIt2,InnerIt2> &right) const
+  {
+    return !(*this==right);
+  }
+};
+
+// Entries of one key in a MultiKeyedSkipList.  Their keys are const, so the
+// list is rebuilt on assignment rather than assigned element by element.
+template<class V, class A>
+class EntryGroup : public std::list<V, A>
+{
+public:
+  EntryGroup() {}
+  EntryGroup(const EntryGroup &source) : std::list<V, A>(source) {}
+
+  EntryGroup& operator=(const EntryGroup &source)
+  {
+    EntryGroup copy(source);
+    this->swap(copy);
+    return *this;
+  }
+};
+
+// Multimap that keeps all entries of one key as a group under a single node
+// of a KeyedSkipList, in the order they were inserted.  The skiplist only
+// ever sees distinct keys, so count(), equal_range() and erase(key) cost one
+// search plus constant work instead of a walk over every duplicate.
+template <class K, class T, class Pr, class R, class A>
+class MultiKeyedSkipList
+{
+public:
+  typedef MultiKeyedSkipList<K,T,Pr,R,A> container_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T& const_mapped_type_reference;
+  typedef EntryGroup<value_type, typename A::template rebind<value_type>::other> group_type;
+  typedef KeyedSkipList<K, group_type, Pr, R, typename A::template rebind<std::pair<const K, group_type> >::other> group_map;
+  typedef GroupIterator<value_type, typename group_map::iterator, typename group_type::iterator> iterator;
+  typedef GroupIterator<const value_type, typename group_map::const_iterator, typename group_type::const_iterator> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+  typedef Pr key_compare;
+
+private:
+  group_map Groups; //!< One node per distinct key.  Groups are never empty.
+  size_type items; //!< Entries over all groups.
+
+  iterator GroupBegin(const typename group_map::iterator &group)
+  {
+    return iterator(group, Groups.end(), (group==Groups.end()) ? typename group_type::iterator() : group->second.begin());
+  }
+
+  const_iterator GroupBegin(const typename group_map::const_iterator &group) const
+  {
+    return const_iterator(group, Groups.end(), (group==Groups.end()) ? typename group_type::const_iterator() : group->second.begin());
+  }
+
+public:
+  MultiKeyedSkipList() : items(0) {}
+  explicit MultiKeyedSkipList(const key_compare& comp) : Groups(comp), items(0) {}
+  MultiKeyedSkipList(double probability, size_type maxLevel) : Groups(probability, maxLevel), items(0) {}
+  template<class InIt> MultiKeyedSkipList(InIt first, InIt last) : items(0) { insert(first, last); }
+
+  iterator begin() { return GroupBegin(Groups.begin()); }
+  iterator end() { return GroupBegin(Groups.end()); }
+  const_iterator begin() const { return GroupBegin(Groups.begin()); }
+  const_iterator end() const { return GroupBegin(Groups.end()); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  size_type size() const { return items; }
+  bool empty() const { return items==0; }
+  size_type max_size() const { return Groups.max_size(); }
+  size_type key_count() const { return Groups.size(); } //!< Number of distinct keys.
+
+  // Adds val after any entries with the same key.
+  iterator insert(const value_type &val)
+  {
+    typename group_map::slpair slot = Groups.insert(typename group_map::value_type(val.first, group_type()));
+    try
+    {
+      slot.first->second.push_back(val);
+    }
+    catch(...)
+    {
+      if (slot.second) Groups.erase(slot.first);
+      throw;
+    }
+    items++;
+    return iterator(slot.first, Groups.end(), --slot.first->second.end());
+  }
+
+  iterator insert(const iterator &where, const value_type& val) { return insert(val); }
+  template<class InIt> void insert(InIt first, InIt last) { for(InIt i=first;i!=last;++i) insert(*i); }
+
+  iterator erase(const iterator &where)
+  {
+    typename group_map::iterator group = where.outer;
+    typename group_type::iterator next = group->second.erase(where.inner);
+    items--;
+    if (next!=group->second.end()) return iterator(group, Groups.end(), next);
+    if (group->second.empty()) group = Groups.erase(group);
+    else ++group;
+    return GroupBegin(group);
+  }
+
+  iterator erase(iterator first, const iterator &last)
+  {
+    while (first!=last) first = erase(first);
+    return first;
+  }
+
+  size_type erase(const key_type &keyval)
+  {
+    typename group_map::iterator group = Groups.find(keyval);
+    if (group==Groups.end()) return 0;
+    size_type erased = group->second.size();
+    Groups.erase(group);
+    items -= erased;
+    return erased;
+  }
+
+  void clear()
+  {
+    Groups.clear();
+    items = 0;
+  }
+
+  void swap(container_type &right)
+  {
+    Groups.swap(right.Groups);
+    std::swap(items, right.items);
+  }
+
+  key_compare key_comp() const { return Groups.key_comp(); }
+
+  // First entry with keyval.
+  iterator find(const key_type &keyval)
+  {
+    typename group_map::iterator group = Groups.find(keyval);
+    return (group==Groups.end()) ? end() : GroupBegin(group);
+  }
+
+  const_iterator find(const key_type &keyval) const
+  {
+    typename group_map::const_iterator group = Groups.find(keyval);
+    return (group==Groups.end()) ? end() : GroupBegin(group);
+  }
+
+  size_type count(const key_type &keyval) const
+  {
+    typename group_map::const_iterator group = Groups.find(keyval);
+    return (group==Groups.end()) ? 0 : group->second.size();
+  }
+
+  iterator lower_bound(const key_type &keyval) { return GroupBegin(Groups.lower_bound(keyval)); }
+  const_iterator lower_bound(const key_type &keyval) const { return GroupBegin(Groups.lower_bound(keyval)); }
+  iterator upper_bound(const key_type &keyval) { return GroupBegin(Groups.upper_bound(keyval)); }
+  const_iterator upper_bound(const key_type &keyval) const { return GroupBegin(Groups.upper_bound(keyval)); }
+
+  ipair equal_range(const key_type &keyval)
+  {
+    typename group_map::iterator group = Groups.lower_bound(keyval);
+    if ((group==Groups.end())||(key_comp()(keyval,group->first))) return ipair(GroupBegin(group), GroupBegin(group));
+    iterator first = GroupBegin(group);
+    return ipair(first, GroupBegin(++group));
+  }
+
+  const_ipair equal_range(const key_type &keyval) const
+  {
+    typename group_map::const_iterator group = Groups.lower_bound(keyval);
+    if ((group==Groups.end())||(key_comp()(keyval,group->first))) return const_ipair(GroupBegin(group), GroupBegin(group));
+    const_iterator first = GroupBegin(group);
+    return const_ipair(first, GroupBegin(++group));
+  }
+};
+
+template <class K, class T, class Pr, class R, class A>
+bool operator==(const MultiKeyedSkipList<K,T,Pr,R,A> &left, const MultiKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+}
+
+template <class K, class T, class Pr, class R, class A>
+bool operator!=(const MultiKeyedSkipList<K,T,Pr,R,A> &left, const MultiKeyedSkipList<K,T,Pr,R,A> &right)
+{
+  return !(left==right);
+}
+
+#undef CSFILTER
+#undef CSLAZY
+#undef CSADAPT
+#undef CSSTATIC
 #undef CSKEY
 #undef CSINDEX
 #undef CSUNIQUE
@@ -0,0 +1,526 @@
+/*
+   Description: Header file for PageFile and PagedSkipList
+                Keyed skiplist whose nodes live in fixed size pages of a
+                file, for maps larger than main memory.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSPagedSkipListH
+#define CSPagedSkipListH
+
+#include <list>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <limits>
+#include <stdio.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+#include "CSSkipListTools.h"
+
+namespace CS
+{
+
+// Turns keys into page bytes and back.  The default copies the key's bytes,
+// so it only suits trivially copyable keys.
+template <class K>
+struct PageCodec
+{
+  static size_t size(const K &) { return sizeof(K); }
+  static void write(unsigned char *p, const K &keyval) { memcpy(p, &keyval, sizeof(K)); }
+  static void read(const unsigned char *p, size_t, K &keyval) { memcpy(&keyval, p, sizeof(K)); }
+};
+
+template <>
+struct PageCodec<std::string>
+{
+  static size_t size(const std::string &keyval) { return keyval.size(); }
+  static void write(unsigned char *p, const std::string &keyval) { memcpy(p, keyval.data(), keyval.size()); }
+  static void read(const unsigned char *p, size_t n, std::string &keyval) { keyval.assign(reinterpret_cast<const char*>(p), n); }
+};
+
+// A file of 4096 byte pages behind a buffer pool.  The first byte of every
+// page holds its PageKind.  Meta and index pages stay resident once loaded;
+// at most leafFrames leaf pages are kept and the least recently used one is
+// written back and dropped to make room.  A pointer returned by fetch() or
+// allocate() is only valid until the next call of either.
+class PageFile
+{
+public:
+  typedef unsigned long long page_id;
+  enum { PageSize = 4096 };
+  enum PageKind { meta_page = 0, index_page = 1, leaf_page = 2 };
+
+  PageFile(const char *path, size_t leafFrames) : capacity(leafFrames<1 ? 1 : leafFrames), pages(0), reads(0), writes(0)
+  {
+    file = fopen(path, "r+b");
+    if (file==NULL) file = fopen(path, "w+b");
+    if (file==NULL) throw std::runtime_error("PageFile: cannot open file");
+    try
+    {
+      pages = Size()/PageSize;
+    }
+    catch (...)
+    {
+      fclose(file);
+      throw;
+    }
+  }
+
+  // Dirty pages are written back, but a failed write cannot be reported
+  // from here; call flush() first to see it.
+  ~PageFile()
+  {
+    try
+    {
+      flush();
+    }
+    catch (...)
+    {
+    }
+    for(std::unordered_map<page_id, Frame*>::iterator i=frames.begin();i!=frames.end();++i) delete i->second;
+    fclose(file);
+  }
+
+  page_id page_count() const { return pages; }
+  size_t leaf_frames() const { return capacity; }
+  size_t resident_pages() const { return frames.size(); }
+  unsigned long long page_reads() const { return reads; }
+  unsigned long long page_writes() const { return writes; }
+
+  // Appends a zeroed page of the given kind.  It is written out on flush()
+  // or when it is evicted.
+  page_id allocate(PageKind kind)
+  {
+    Frame *frame = new Frame;
+    frame->page = pages++;
+    memset(frame->data, 0, PageSize);
+    frame->data[0] = (unsigned char)kind;
+    frame->dirty = true;
+    Admit(frame);
+    return frame->page;
+  }
+
+  unsigned char* fetch(page_id page, bool write = false)
+  {
+    Frame *frame;
+    std::unordered_map<page_id, Frame*>::iterator i = frames.find(page);
+    if (i!=frames.end())
+    {
+      frame = i->second;
+      if (frame->data[0]==leaf_page) lru.splice(lru.begin(), lru, frame->lru);
+    }
+    else
+    {
+      frame = new Frame;
+      frame->page = page;
+      frame->dirty = false;
+      Seek(page);
+      if (fread(frame->data, PageSize, 1, file)!=1)
+      {
+        delete frame;
+        throw std::runtime_error("PageFile: short read");
+      }
+      reads++;
+      Admit(frame);
+    }
+    if (write) frame->dirty = true;
+    return frame->data;
+  }
+
+  // Writes every dirty page back, resident pages stay resident.
+  void flush()
+  {
+    for(std::unordered_map<page_id, Frame*>::iterator i=frames.begin();i!=frames.end();++i)
+    {
+      if (i->second->dirty) Write(i->second);
+    }
+    fflush(file);
+  }
+
+private:
+  struct Frame
+  {
+    page_id page;
+    bool dirty;
+    std::list<Frame*>::iterator lru; //!< Position in lru, leaf pages only.
+    unsigned char data[PageSize];
+  };
+
+  FILE *file;
+  size_t capacity;  //!< Leaf pages the pool may hold.
+  page_id pages;
+  unsigned long long reads, writes;
+  std::unordered_map<page_id, Frame*> frames;
+  std::list<Frame*> lru; //!< Resident leaf pages, most recently used first.
+
+  void Admit(Frame *frame)
+  {
+    frames[frame->page] = frame;
+    if (frame->data[0]!=leaf_page) return;
+    lru.push_front(frame);
+    frame->lru = lru.begin();
+    while (lru.size()>capacity)
+    {
+      Frame *victim = lru.back();
+      lru.pop_back();
+      if (victim->dirty) Write(victim);
+      frames.erase(victim->page);
+      delete victim;
+    }
+  }
+
+  // fseek() takes a long, which is 32 bits on Windows and 32 bit targets,
+  // so files past 2 GB go through the 64 bit calls.  On 32 bit POSIX
+  // targets off_t is only 64 bits with _FILE_OFFSET_BITS=64; without it
+  // offsets that do not fit are refused rather than wrapped.
+  void Seek(page_id page)
+  {
+#if defined(_WIN32)
+    typedef __int64 offset_type;
+#else
+    typedef off_t offset_type;
+#endif
+    if (page>(page_id)std::numeric_limits<offset_type>::max()/PageSize) throw std::runtime_error("PageFile: page beyond the largest file offset");
+    offset_type offset = (offset_type)page*PageSize;
+#if defined(_WIN32)
+    int failed = _fseeki64(file, offset, SEEK_SET);
+#else
+    int failed = fseeko(file, offset, SEEK_SET);
+#endif
+    if (failed!=0) throw std::runtime_error("PageFile: seek failed");
+  }
+
+  page_id Size()
+  {
+#if defined(_WIN32)
+    if (_fseeki64(file, 0, SEEK_END)!=0) throw std::runtime_error("PageFile: seek failed");
+    __int64 size = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END)!=0) throw std::runtime_error("PageFile: seek failed");
+    off_t size = ftello(file);
+#endif
+    if (size<0) throw std::runtime_error("PageFile: cannot tell file size");
+    return (page_id)size;
+  }
+
+  void Write(Frame *frame)
+  {
+    Seek(frame->page);
+    if (fwrite(frame->data, PageSize, 1, file)!=1) throw std::runtime_error("PageFile: short write");
+    frame->dirty = false;
+    writes++;
+  }
+};
+
+// Keyed skiplist stored in a PageFile.  A node is a record of its level, key
+// length, value, forward references and key bytes; a reference is the page
+// number shifted left by 12 bits plus the offset in the page, and 0 is the
+// end of a level.  Nodes that reach level 1 or higher go to index pages, so
+// the upper levels stay resident and a search only reads leaf pages for the
+// last few steps on level 0.  A level 0 node goes to its predecessor's page
+// when that has room, which keeps range scans on few pages.
+//
+// Supports insert, find, range scans and flush(); there is no erase.  T
+// must be trivially copyable and records are stored in native byte order.
+// Opening an existing file continues the list flushed into it, with the
+// probability and maxLevel it was created with.
+template <class K, class T, class Pr, class R, class C = PageCodec<K> >
+class PagedSkipList
+{
+public:
+  typedef size_t size_type;
+  typedef K key_type;
+  typedef T mapped_type;
+  typedef std::pair<const K, T> value_type;
+  typedef Pr key_compare;
+  typedef GeometricLevels level_generator;
+  typedef unsigned long long node_ref;
+  typedef PageFile::page_id page_id;
+
+  static_assert(std::is_trivially_copyable<T>::value, "PagedSkipList stores mapped values as raw bytes");
+
+  PagedSkipList(const char *path, size_type poolPages, double probability = 0.25, unsigned int maxLevel = 15)
+    : file(path, poolPages), probability(probability), maxLevel(maxLevel), level(0), items(0), leafPages(0), indexFill(0), leafFill(0)
+  {
+    if (this->maxLevel>MaxLevelLimit) this->maxLevel = MaxLevelLimit;
+    if (file.page_count()==0) Create();
+    else Open();
+    update.resize(this->maxLevel+1);
+  }
+
+  // As with PageFile, call flush() first to see write errors.
+  ~PagedSkipList()
+  {
+    try
+    {
+      flush();
+    }
+    catch (...)
+    {
+    }
+  }
+
+  size_type size() const { return items; }
+  bool empty() const { return items==0; }
+  key_compare key_comp() const { return KeyCompare; }
+
+  page_id page_count() const { return file.page_count(); }
+  page_id leaf_page_count() const { return leafPages; }
+  size_type pool_pages() const { return file.leaf_frames(); }
+  unsigned long long page_reads() const { return file.page_reads(); }
+  unsigned long long page_writes() const { return file.page_writes(); }
+
+  // Returns false and changes nothing when the key is already present.
+  bool insert(const value_type &val)
+  {
+    node_ref next = Descend(val.first);
+    if ((next!=0)&&(!KeyCompare(val.first, scratch))) return false;
+
+    unsigned int newLevel = GenerateRandomLevel();
+    size_type keyLen = C::size(val.first);
+    size_type bytes = RecordSize(newLevel, keyLen);
+    if ((bytes>PageFile::PageSize-PageHeader)||(keyLen>0xFFFF)) throw std::length_error("PagedSkipList: key does not fit in a page");
+
+    if (newLevel>level)
+    {
+      for(unsigned int i=level+1;i<=newLevel;i++) update[i] = head;
+      level = newLevel;
+    }
+
+    /* Read the successors first, fetching them may evict the new node's page. */
+    node_ref forward[MaxLevelLimit+1];
+    for(unsigned int i=0;i<=newLevel;i++) forward[i] = Forward(update[i], i);
+
+    node_ref node = Place(newLevel, bytes);
+    unsigned char *rec = file.fetch(Page(node), true)+Offset(node);
+    unsigned short len = (unsigned short)keyLen;
+    rec[0] = (unsigned char)newLevel;
+    memcpy(rec+2, &len, sizeof(len));
+    memcpy(rec+ValueOffset, &val.second, sizeof(T));
+    memcpy(rec+ForwardOffset, forward, (newLevel+1)*sizeof(node_ref));
+    C::write(rec+ForwardOffset+(newLevel+1)*sizeof(node_ref), val.first);
+
+    for(unsigned int i=0;i<=newLevel;i++) SetForward(update[i], i, node);
+    items++;
+    return true;
+  }
+
+  template<class InIt> void insert(InIt first, InIt last) { for(InIt i=first;i!=last;++i) insert(*i); }
+
+  bool find(const key_type &keyval, mapped_type &value) const
+  {
+    node_ref node = Descend(keyval);
+    if ((node==0)||(KeyCompare(keyval, scratch))) return false;
+    memcpy(&value, Record(node)+ValueOffset, sizeof(T));
+    return true;
+  }
+
+  bool contains(const key_type &keyval) const
+  {
+    node_ref node = Descend(keyval);
+    return (node!=0)&&(!KeyCompare(keyval, scratch));
+  }
+
+  // Calls f(key, value) for every key in [first,last) in order and returns
+  // how many there were.  f must not use the list.
+  template<class F> size_type scan(const key_type &first, const key_type &last, F f) const
+  {
+    node_ref node = Descend(first);
+    size_type n = 0;
+    T value;
+    while (node!=0)
+    {
+      const unsigned char *rec = Record(node);
+      ReadKey(rec, scratch);
+      if (!KeyCompare(scratch, last)) break;
+      memcpy(&value, rec+ValueOffset, sizeof(T));
+      node = ReadForward(rec, 0);
+      f(static_cast<const key_type&>(scratch), static_cast<const T&>(value));
+      n++;
+    }
+    return n;
+  }
+
+  // Writes the list's header and every dirty page to the file.
+  void flush()
+  {
+    unsigned char *meta = file.fetch(0, true);
+    memcpy(meta+8, Magic(), 8);
+    unsigned int fields[2] = { maxLevel, level };
+    memcpy(meta+16, fields, sizeof(fields));
+    unsigned long long refs[6] = { items, head, indexFill, leafFill, leafPages, 0 };
+    memcpy(meta+24, refs, sizeof(refs));
+    memcpy(meta+72, &probability, sizeof(probability));
+    file.flush();
+  }
+
+private:
+  enum { PageHeader = 8, ValueOffset = 4, ForwardOffset = 4+sizeof(T), MaxLevelLimit = 63 };
+  static const char* Magic() { return "CSPSKIP1"; }
+
+  R rng;
+  key_compare KeyCompare;
+  mutable PageFile file;
+  double probability; //!< Probability to go to the next level.
+  unsigned int maxLevel;
+  unsigned int level;
+  size_type items;
+  page_id leafPages;
+  node_ref head;      //!< Record with maxLevel+1 forward references and no key.
+  page_id indexFill;  //!< Index page new upper level nodes go to.
+  page_id leafFill;   //!< Leaf page new level 0 nodes go to when their predecessor's page is full.
+  mutable std::vector<node_ref> update;
+  mutable key_type scratch; //!< Last key read from a page, reused to save allocations.
+
+  CSDefineGenerateRandomLevel
+
+  static page_id Page(node_ref node) { return node>>12; }
+  static size_type Offset(node_ref node) { return (size_type)(node&0xFFF); }
+  static size_type RecordSize(unsigned int level, size_type keyLen) { return ForwardOffset+(level+1)*sizeof(node_ref)+keyLen; }
+
+  const unsigned char* Record(node_ref node) const { return file.fetch(Page(node))+Offset(node); }
+
+  static node_ref ReadForward(const unsigned char *rec, unsigned int i)
+  {
+    node_ref next;
+    memcpy(&next, rec+ForwardOffset+i*sizeof(node_ref), sizeof(next));
+    return next;
+  }
+
+  static void ReadKey(const unsigned char *rec, key_type &keyval)
+  {
+    unsigned short len;
+    memcpy(&len, rec+2, sizeof(len));
+    C::read(rec+ForwardOffset+(rec[0]+1)*sizeof(node_ref), len, keyval);
+  }
+
+  node_ref Forward(node_ref node, unsigned int i) const { return ReadForward(Record(node), i); }
+
+  void SetForward(node_ref node, unsigned int i, node_ref next)
+  {
+    unsigned char *rec = file.fetch(Page(node), true)+Offset(node);
+    memcpy(rec+ForwardOffset+i*sizeof(node_ref), &next, sizeof(next));
+  }
+
+  // Fills update with the last node before keyval on every level and returns
+  // the node after it on level 0, or 0.  scratch then holds that node's key.
+  node_ref Descend(const key_type &keyval) const
+  {
+    node_ref cursor = head;
+    node_ref next = 0;
+    for(int i=level;i>=0;i--)
+    {
+      next = Forward(cursor, i);
+      while (next!=0)
+      {
+        const unsigned char *rec = Record(next);
+        ReadKey(rec, scratch);
+        if (!KeyCompare(scratch, keyval)) break;
+        cursor = next;
+        next = ReadForward(rec, i);
+      }
+      update[i] = cursor;
+    }
+    return next;
+  }
+
+  size_type Room(page_id page) const
+  {
+    const unsigned char *p = file.fetch(page);
+    unsigned short used;
+    memcpy(&used, p+2, sizeof(used));
+    return PageFile::PageSize-used;
+  }
+
+  // Reserves bytes for a new node and returns its reference.
+  node_ref Place(unsigned int newLevel, size_type bytes)
+  {
+    page_id page;
+    if (newLevel>0)
+    {
+      if ((indexFill==0)||(Room(indexFill)<bytes)) indexFill = file.allocate(PageFile::index_page);
+      page = indexFill;
+    }
+    else
+    {
+      page = Page(update[0]);
+      if ((update[0]==head)||(file.fetch(page)[0]!=PageFile::leaf_page)||(Room(page)<bytes))
+      {
+        if ((leafFill==0)||(Room(leafFill)<bytes))
+        {
+          leafFill = file.allocate(PageFile::leaf_page);
+          leafPages++;
+        }
+        page = leafFill;
+      }
+    }
+
+    unsigned char *p = file.fetch(page, true);
+    unsigned short used;
+    memcpy(&used, p+2, sizeof(used));
+    if (used==0) used = PageHeader;
+    node_ref node = (page<<12)|used;
+    used = (unsigned short)(used+bytes);
+    memcpy(p+2, &used, sizeof(used));
+    return node;
+  }
+
+  void Create()
+  {
+    file.allocate(PageFile::meta_page);
+    indexFill = file.allocate(PageFile::index_page);
+    head = Place(maxLevel, RecordSize(maxLevel, 0));
+    unsigned char *rec = file.fetch(Page(head), true)+Offset(head);
+    rec[0] = (unsigned char)maxLevel;
+    flush();
+  }
+
+  void Open()
+  {
+    const unsigned char *meta = file.fetch(0);
+    if (memcmp(meta+8, Magic(), 8)!=0) throw std::runtime_error("PagedSkipList: not a skiplist file");
+    unsigned int fields[2];
+    memcpy(fields, meta+16, sizeof(fields));
+    unsigned long long refs[6];
+    memcpy(refs, meta+24, sizeof(refs));
+    memcpy(&probability, meta+72, sizeof(probability));
+    maxLevel = fields[0];
+    level = fields[1];
+    items = (size_type)refs[0];
+    head = refs[1];
+    indexFill = refs[2];
+    leafFill = refs[3];
+    leafPages = refs[4];
+
+    // Levels size the stack and update arrays, and every reference is
+    // followed, so a foreign or corrupt header is refused up front.
+    page_id pages = file.page_count();
+    if ((maxLevel>MaxLevelLimit)||(level>maxLevel)||!((probability>0.0)&&(probability<1.0))||
+        (Page(head)==0)||(Page(head)>=pages)||(Offset(head)<PageHeader)||
+        (Offset(head)+RecordSize(maxLevel, 0)>PageFile::PageSize)||
+        (indexFill>=pages)||(leafFill>=pages)||(leafPages>=pages))
+      throw std::runtime_error("PagedSkipList: corrupt header");
+    const unsigned char *rec = Record(head);
+    if (rec[0]!=maxLevel) throw std::runtime_error("PagedSkipList: corrupt header");
+  }
+};
+
+}
+
+#endif
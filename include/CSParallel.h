@@ -0,0 +1,318 @@
+/*
+   Description: Header file for WorkStealingPool and the parallel algorithms
+                that run over the ranges returned by a skiplist's split().
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSParallelH
+#define CSParallelH
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+namespace CS
+{
+
+// Thread pool with one task queue per worker.  A worker takes its own
+// newest task first and steals the oldest task of another worker when its
+// queue runs dry.  The thread calling wait() helps until all tasks are done.
+class WorkStealingPool
+{
+public:
+  typedef size_t size_type;
+  typedef std::function<void()> task_type;
+
+  explicit WorkStealingPool(unsigned int threads = 0) : stop(false), pending(0), queued(0), next(0)
+  {
+    if (threads==0) threads = std::thread::hardware_concurrency();
+    if (threads==0) threads = 1;
+    for(unsigned int i=0;i<threads;i++) queues.push_back(std::unique_ptr<Queue>(new Queue));
+    for(unsigned int i=0;i<threads;i++) workers.push_back(std::thread(&WorkStealingPool::Work, this, i));
+  }
+
+  ~WorkStealingPool()
+  {
+    {
+      std::lock_guard<std::mutex> guard(idleLock);
+      stop = true;
+    }
+    idle.notify_all();
+    for(size_type i=0;i<workers.size();i++) workers[i].join();
+  }
+
+  unsigned int size() const { return (unsigned int)queues.size(); }
+
+  void submit(task_type task)
+  {
+    unsigned int q = Self();
+    if (q>=queues.size()) q = (next++)%queues.size();
+    pending++;
+    {
+      std::lock_guard<std::mutex> guard(queues[q]->lock);
+      queues[q]->tasks.push_back(std::move(task));
+    }
+    queued++;
+    {
+      std::lock_guard<std::mutex> guard(idleLock);
+    }
+    idle.notify_one();
+  }
+
+  // Runs tasks on the calling thread until every submitted task has
+  // finished.  Rethrows the first exception a task threw.
+  void wait()
+  {
+    unsigned int self = Self();
+    if (self>=queues.size()) self = 0;
+    while (pending!=0)
+    {
+      if (!TryRun(self)) std::this_thread::yield();
+    }
+    std::exception_ptr e;
+    {
+      std::lock_guard<std::mutex> guard(errorLock);
+      std::swap(e, error);
+    }
+    if (e) std::rethrow_exception(e);
+  }
+
+private:
+  struct Queue
+  {
+    std::mutex lock;
+    std::deque<task_type> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue> > queues;
+  std::vector<std::thread> workers;
+  std::mutex idleLock;
+  std::condition_variable idle;
+  bool stop;
+  std::atomic<size_type> pending; //!< Tasks submitted but not finished.
+  std::atomic<size_type> queued;  //!< Tasks waiting in a queue.
+  std::atomic<unsigned int> next; //!< Round robin queue for outside submits.
+  std::mutex errorLock;
+  std::exception_ptr error;
+
+  // Index of the worker running on this thread, or size() for other threads.
+  unsigned int Self() const
+  {
+    std::thread::id id = std::this_thread::get_id();
+    for(unsigned int i=0;i<workers.size();i++)
+    {
+      if (workers[i].get_id()==id) return i;
+    }
+    return (unsigned int)queues.size();
+  }
+
+  bool TryRun(unsigned int self)
+  {
+    task_type task;
+    for(unsigned int i=0;i<queues.size();i++)
+    {
+      Queue &q = *queues[(self+i)%queues.size()];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if (q.tasks.empty()) continue;
+      if (i==0)
+      {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      }
+      else
+      {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      queued--;
+      break;
+    }
+    if (!task) return false;
+
+    try
+    {
+      task();
+    }
+    catch(...)
+    {
+      std::lock_guard<std::mutex> guard(errorLock);
+      if (!error) error = std::current_exception();
+    }
+    pending--;
+    return true;
+  }
+
+  void Work(unsigned int self)
+  {
+    for(;;)
+    {
+      if (TryRun(self)) continue;
+      std::unique_lock<std::mutex> guard(idleLock);
+      if (stop) return;
+      if (queued==0) idle.wait(guard);
+    }
+  }
+};
+
+inline WorkStealingPool& default_pool()
+{
+  static WorkStealingPool pool;
+  return pool;
+}
+
+// Number of ranges per thread.  More ranges than threads lets stealing even
+// out ranges that split() could not make equal.
+const size_t parallel_oversplit = 4;
+
+template<class C, class F>
+void parallel_for_each(const C &container, F f, WorkStealingPool &pool = default_pool())
+{
+  typedef typename C::const_iterator const_iterator;
+  std::vector<std::pair<const_iterator,const_iterator> > ranges = container.split(pool.size()*parallel_oversplit);
+  for(size_t i=0;i<ranges.size();i++)
+  {
+    std::pair<const_iterator,const_iterator> r = ranges[i];
+    pool.submit([r,&f]() { std::for_each(r.first, r.second, f); });
+  }
+  pool.wait();
+}
+
+template<class C, class Pr1>
+size_t parallel_count_if(const C &container, Pr1 pred, WorkStealingPool &pool = default_pool())
+{
+  typedef typename C::const_iterator const_iterator;
+  std::vector<std::pair<const_iterator,const_iterator> > ranges = container.split(pool.size()*parallel_oversplit);
+  std::vector<size_t> counts(ranges.size());
+  for(size_t i=0;i<ranges.size();i++)
+  {
+    std::pair<const_iterator,const_iterator> r = ranges[i];
+    size_t *out = &counts[i];
+    pool.submit([r,out,&pred]() { *out = std::count_if(r.first, r.second, pred); });
+  }
+  pool.wait();
+
+  size_t total = 0;
+  for(size_t i=0;i<counts.size();i++) total += counts[i];
+  return total;
+}
+
+// Folds transform(x) for every element into init with reduce.  reduce must
+// be associative; init is used once, so it need not be an identity.
+template<class C, class V, class Reduce, class Transform>
+V parallel_transform_reduce(const C &container, V init, Reduce reduce, Transform transform, WorkStealingPool &pool = default_pool())
+{
+  typedef typename C::const_iterator const_iterator;
+  std::vector<std::pair<const_iterator,const_iterator> > ranges = container.split(pool.size()*parallel_oversplit);
+  std::vector<std::unique_ptr<V> > partials(ranges.size());
+  for(size_t i=0;i<ranges.size();i++)
+  {
+    std::pair<const_iterator,const_iterator> r = ranges[i];
+    std::unique_ptr<V> *out = &partials[i];
+    pool.submit([r,out,&reduce,&transform]()
+    {
+      const_iterator it = r.first;
+      V acc = transform(*it);
+      for(++it;it!=r.second;++it) acc = reduce(acc, transform(*it));
+      out->reset(new V(acc));
+    });
+  }
+  pool.wait();
+
+  for(size_t i=0;i<partials.size();i++) init = reduce(init, *partials[i]);
+  return init;
+}
+
+// Stable sort.  Chunks are sorted by the pool, then merged pairwise into a
+// scratch buffer.  Each merge is cut into pieces at a binary searched split
+// point, so the last rounds keep every thread busy too.
+template<class RanIt, class Compare>
+void parallel_sort(RanIt first, RanIt last, Compare comp, WorkStealingPool &pool = default_pool())
+{
+  typedef typename std::iterator_traits<RanIt>::value_type value_type;
+  size_t n = last-first;
+  size_t parts = pool.size()*parallel_oversplit;
+  if (parts>(n+4095)/4096) parts = (n+4095)/4096;
+  if (parts<2)
+  {
+    std::stable_sort(first, last, comp);
+    return;
+  }
+
+  std::vector<size_t> bounds(parts+1);
+  for(size_t c=0;c<=parts;c++) bounds[c] = c*n/parts;
+  for(size_t c=0;c<parts;c++)
+  {
+    RanIt lo = first+bounds[c], hi = first+bounds[c+1];
+    pool.submit([lo,hi,&comp]() { std::stable_sort(lo, hi, comp); });
+  }
+  pool.wait();
+
+  std::vector<value_type> buffer(first, last);
+  for(size_t step=1;step<parts;step*=2)
+  {
+    size_t merges = (parts+2*step-1)/(2*step);
+    size_t pieces = (parts+merges-1)/merges;
+    for(size_t c=0;c<parts;c+=2*step)
+    {
+      size_t lo = bounds[c];
+      size_t mid = bounds[std::min(c+step, parts)];
+      size_t hi = bounds[std::min(c+2*step, parts)];
+      RanIt a = first+lo, b = first+mid;
+      for(size_t k=0;k<pieces;k++)
+      {
+        // Elements of the right half equal to the split element go after
+        // it, which keeps the merge stable.
+        size_t i0 = (mid-lo)*k/pieces, i1 = (mid-lo)*(k+1)/pieces;
+        RanIt b0 = (k==0) ? b : std::lower_bound(b, first+hi, *(a+i0), comp);
+        RanIt b1 = (k+1==pieces) ? first+hi : std::lower_bound(b, first+hi, *(a+i1), comp);
+        typename std::vector<value_type>::iterator out = buffer.begin()+lo+i0+(b0-b);
+        pool.submit([a,i0,i1,b0,b1,out,&comp]() { std::merge(a+i0, a+i1, b0, b1, out, comp); });
+      }
+    }
+    pool.wait();
+    std::copy(buffer.begin(), buffer.end(), first);
+  }
+}
+
+// Fills an empty or non-empty container with [first,last) without a
+// descent per element: pointers to the input are sorted in parallel, later
+// duplicates of a key are dropped as insert() would drop them, and the list
+// is linked by assign_sorted().  The input must stay alive until the call
+// returns and *first should be the container's value_type, otherwise every
+// comparison converts.
+template<class C, class FwdIt>
+void parallel_build(C &container, FwdIt first, FwdIt last, WorkStealingPool &pool = default_pool())
+{
+  typedef typename std::iterator_traits<FwdIt>::value_type value_type;
+  std::vector<const value_type*> items;
+  for(FwdIt i=first;i!=last;++i) items.push_back(&*i);
+
+  typename C::value_compare comp = container.value_comp();
+  parallel_sort(items.begin(), items.end(), [&comp](const value_type *a, const value_type *b) { return comp(*a, *b); }, pool);
+  items.erase(std::unique(items.begin(), items.end(), [&comp](const value_type *a, const value_type *b) { return !comp(*a, *b); }), items.end());
+
+  container.assign_sorted(items.begin(), items.end(), pool);
+}
+
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*
+   Description: Header file for SkipListSet
+                Double linked skiplist that acts like a set.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSSkipListSetH
+#define CSSkipListSetH
+
+#include <utility>
+#include <iterator>
+#include <functional>
+#include "CSSkipListTools.h"
+#include "CSIterators.h"
+
+namespace CS
+{
+#define CSBIDI(a,b) a
+#define CSUNIQUE(a,b) a
+#define CSINDEX(a,b) b
+#define CSKEY(a,b) a
+#define CSLEVEL(a,b) a
+#define CSFILTER(a,b) b
+#define CSLAZY(a,b) b
+#define CSSTATIC(a,b) b
+#define CSADAPT(a,b) b
+
+// KeyedSkipList without mapped values: the nodes hold the key alone, which
+// is its own key through XAccessSelf, so a node is the links plus the key.
+// Search, insert and erase are the same macros as KeyedSkipList.  Elements
+// cannot be changed through iterators, as with std::set.  There is no
+// membership filter and no lazy deletion.
+template <class K, class Pr, class R, class A>
+class SkipListSet
+{
+public:
+  typedef CSUNIQUE(CSKEY(uniquekey_tag,unique_tag),CSKEY(multikey_tag,multi_tag)) tag;
+  typedef SkipListSet<K,Pr,R,A> container_type;
+  typedef BidiIterator<container_type> T0;
+  typedef ConstBidiIterator<container_type> T1;
+  friend class BidiIterator<container_type>;
+  friend class ConstBidiIterator<container_type>;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef K value_type;
+  typedef BidiNode<value_type> node_type;
+  typedef T0 iterator;
+  typedef const value_type* pointer;
+  typedef const value_type& reference;
+  // The iterators expect a mapped type; for a set it is the key.
+  typedef K data_type;
+  typedef K mapped_type;
+  typedef const K& mapped_type_reference;
+  typedef const K const_mapped_type;
+  typedef const K& const_mapped_type_reference;
+  typedef const value_type& const_reference;
+  typedef T1 const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+  typedef Pr key_compare;
+  typedef Pr value_compare;
+  typedef KeyOrder<Pr, K> key_order;
+  typedef GeometricLevels level_generator;
+
+private:
+  R rng;
+  key_compare KeyCompare;
+  size_type maxLevel; //!< Maximum number of forward pointers possible, at most 255.
+  size_type level;    //!< The maximum number of forward pointers on any given container currently in use.
+  node_type *head,*tail; //!< Start and end containers.
+  double probability; //!< Probability to go to the next level.
+  size_type items; //!< Number of items in the list.
+  mutable std::pair<size_type,node_type*> *update;
+  CSDefineInit
+  node_type* Alloc(size_type level, const value_type &obj) CSAlloc2(A, level,obj,node_type)
+  node_type* Alloc(size_type level) CSAlloc(A, level,node_type)
+  void Free(node_type *item) CSFree(A, item,node_type)
+  CSDefineGenerateRandomLevel
+  CSDefineAdjustLevels
+  CSDefineScanKey
+  CSDefineScanVal
+  CSDefineScanIterator
+  CSDefineScanNode
+  CSDefineScanBack
+public:
+
+  CheckSkipNodes
+  CSDefineStats
+
+  SkipListSet() : KeyCompare(Pr()) { CSInitDefault; }
+  explicit SkipListSet(size_type maxNodes) : KeyCompare(Pr()) { CSInitMaxNodes; }
+  SkipListSet(double probability, size_type maxLevel) : KeyCompare(Pr()) { CSInitPM; }
+  SkipListSet(const container_type &source) : KeyCompare(source.KeyCompare) { CSInitCore(source.probability, source.maxLevel) CSCopyITIT(const_iterator, source.begin(),source.end(),insert); }
+  template<class InIt> SkipListSet(InIt first, InIt last) : KeyCompare(Pr()) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
+  explicit SkipListSet(const key_compare& comp) : KeyCompare(comp) { CSInitDefault; }
+  template<class InIt> SkipListSet(InIt first, InIt last, const key_compare& comp) : KeyCompare(comp) { CSInitDefault; CSCopyITIT(InIt, first,last,insert); }
+  ~SkipListSet() { clear(); Free(head); Free(tail); delete[] update; }
+  CSDefineOperatorEqual
+
+  CSDefineBeginEnd
+  CSDefineRBeginEnd
+  CSDefineSize
+  CSDefineEmpty
+  CSDefineFront
+  CSDefineBackBidi
+  CSDefinePopFront
+  CSDefinePopBackBidi
+  CSDefineAssignITIT(insert)
+
+  CSDefineInsertVal
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; } // Don't use this.  Calls insert(const value_type& type);
+  template<class InIt> void insert(InIt first, InIt last) { CSCopyITIT(InIt, first, last, insert); }
+
+  CSDefineErase
+  CSDefineEraseITIT
+  CSDefineEraseKey
+
+  CSDefineClear
+  void swap(container_type& right) { CSSwapCore std::swap(KeyCompare, right.KeyCompare); }
+  CSDefineEraseIf
+
+  CSDefineCut
+  CSDefineSplit
+  CSDefineAssignSorted
+  CSDefineInsertBatch
+  CSDefineRebalance
+
+  CSDefineKeyCompare(KeyCompare)
+  CSDefineValueCompare(KeyCompare)
+  CSDefineMaxSize
+
+  const key_type& key(const_reference value) const {return XAccessSelf<K,value_type>()(value);}
+  CSDefineFind
+  CSDefineFindSteps
+  CSDefineCount
+  CSDefineLowerBound
+  CSDefineUpperBound
+  CSDefineEqualRange
+  CSDefinePrefix
+};
+
+template <class K, class Pr, class R, class A>
+bool operator==(const SkipListSet<K,Pr,R,A> &left, const SkipListSet<K,Pr,R,A> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+
+}
+
+template <class K, class Pr, class R, class A>
+bool operator<(const SkipListSet<K,Pr,R,A> &left, const SkipListSet<K,Pr,R,A> &right)
+{
+  return lexicographical_compare(left.begin(),left.end(),right.begin(),right.end(),left.value_comp());
+}
+
+#define csarg1 template<class K, class Pr, class R, class A>
+#define csarg2 SkipListSet<K,Pr,R,A>
+CSDefineCompOps(csarg1, csarg2)
+#undef csarg1
+#undef csarg2
+
+#undef CSFILTER
+#undef CSLAZY
+#undef CSADAPT
+#undef CSSTATIC
+#undef CSKEY
+#undef CSINDEX
+#undef CSUNIQUE
+#undef CSBIDI
+#undef CSLEVEL
+
+}
+
+
+#endif
@@ -22,6 +22,12 @@
 #include <stddef.h>
 #include <math.h>
 #include <iterator>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <functional>
 
 namespace CS
 {
@@ -46,6 +52,121 @@ public:
   bool operator==(const T &right) { return value==right; }
 };
 
+// Three-way key comparison for searches.  order() is negative, zero or
+// positive as a sorts before, with or after b.  When exact is false it only
+// tells below (-1) from not below (1), at the cost of one call to the
+// comparator, and the caller settles equality itself.  Comparators with a
+// compare(a, b) member, and std::less and std::greater on strings, answer
+// all three cases with one comparison.
+template<class Pr, class K, class = void>
+struct KeyOrder
+{
+  static const bool exact = false;
+  static int order(const Pr &comp, const K &a, const K &b) { return comp(a,b) ? -1 : 1; }
+  static bool equal(const Pr &comp, const K &a, const K &b) { return (!comp(a,b))&&(!comp(b,a)); }
+};
+
+template<class Pr, class K>
+struct KeyOrder<Pr, K, decltype((void)std::declval<const Pr&>().compare(std::declval<const K&>(), std::declval<const K&>()))>
+{
+  static const bool exact = true;
+  static int order(const Pr &comp, const K &a, const K &b) { return comp.compare(a,b); }
+  static bool equal(const Pr &comp, const K &a, const K &b) { return comp.compare(a,b)==0; }
+};
+
+template<class C, class Tr, class A>
+struct KeyOrder<std::less<std::basic_string<C,Tr,A> >, std::basic_string<C,Tr,A>, void>
+{
+  typedef std::basic_string<C,Tr,A> K;
+  static const bool exact = true;
+  static int order(const std::less<K>&, const K &a, const K &b) { return a.compare(b); }
+  static bool equal(const std::less<K>&, const K &a, const K &b) { return a==b; }
+};
+
+template<class C, class Tr, class A>
+struct KeyOrder<std::greater<std::basic_string<C,Tr,A> >, std::basic_string<C,Tr,A>, void>
+{
+  typedef std::basic_string<C,Tr,A> K;
+  static const bool exact = true;
+  static int order(const std::greater<K>&, const K &a, const K &b) { return b.compare(a); }
+  static bool equal(const std::greater<K>&, const K &a, const K &b) { return a==b; }
+};
+
+// Level generators, used as static draw(rng, probability, maxLevel).
+// GeometricLevels tosses a drand() coin per level and works for any
+// probability.  BitLevels<Bits> takes the trailing zero bits of one rand()
+// call, Bits of them per level, so its probability is always 2^-Bits.
+// rand() is expected to give at least 31 random bits.  probability(p) is
+// the probability a generator really draws with when the container asks
+// for p; Init stores that, so rebalance() and stats() agree with draw().
+struct GeometricLevels
+{
+  static double probability(double requested) { return requested; }
+  template<class R> static unsigned int draw(R &rng, double probability, size_t maxLevel)
+  {
+    unsigned int newLevel = 0;
+    while ((newLevel<maxLevel)&&(rng.drand()<probability))
+    {
+      newLevel++;
+    }
+    return newLevel;
+  }
+};
+
+template<unsigned int Bits>
+struct BitLevels
+{
+  static double probability(double) { return 1.0/(double)(1u<<Bits); }
+  template<class R> static unsigned int draw(R &rng, double, size_t maxLevel)
+  {
+    unsigned int bits = (unsigned int)rng.rand()|0x80000000u;
+#if defined(__GNUC__)
+    unsigned int zeros = __builtin_ctz(bits);
+#else
+    unsigned int zeros = 0;
+    while (!(bits&1)) { bits >>= 1; zeros++; }
+#endif
+    unsigned int newLevel = zeros/Bits;
+    return (newLevel<maxLevel) ? newLevel : (unsigned int)maxLevel;
+  }
+};
+
+// Compile-time choices KeyedSkipList makes per key type, passed as its last
+// template parameter: key_order is the search strategy (see KeyOrder) and
+// level_generator draws the level of every new node.  The node layout and
+// link direction come from the container itself (KeyedSkipList or
+// ForwardKeyedSkipList), and allocation from its allocator; they are not
+// policies.
+template<class K, class Pr, class Levels = GeometricLevels>
+struct SkipListPolicy
+{
+  typedef KeyOrder<Pr, K> key_order;
+  typedef Levels level_generator;
+};
+
+// Sets next to the smallest string above every string that starts with
+// prefix: the prefix with its last character that can still grow increased,
+// and everything after it dropped.  Characters are ordered by the traits, as
+// std::less on the string does.  Returns false when there is no such string
+// (prefix empty or made only of the largest character).
+template<class C, class Tr, class A>
+bool PrefixSuccessor(const std::basic_string<C,Tr,A> &prefix, std::basic_string<C,Tr,A> &next)
+{
+  next = prefix;
+  while (!next.empty())
+  {
+    C last = next[next.size()-1];
+    C bigger = Tr::to_char_type(Tr::to_int_type(last)+1);
+    if (Tr::lt(last,bigger))
+    {
+      next[next.size()-1] = bigger;
+      return true;
+    }
+    next.erase(next.size()-1);
+  }
+  return false;
+}
+
 class level_exception : public std::exception
 {
 public:
@@ -130,6 +251,33 @@ public:
 #endif
 
 
+// Flags in BidiNode::state used by lazy deletion.
+enum NodeState
+{
+  node_dead = 1,  //!< Erased, but still linked until compact() frees it.
+  node_queued = 2 //!< Listed in the container's graveyard.
+};
+
+// Contains forward pointers only.  Half the pointer memory of a BidiNode,
+// but stepping back means searching from the head again.
+template <class T>
+class ForwardNode
+{
+public:
+  typedef size_t size_type;
+  typedef ForwardNode<T>* ptr_type;
+
+  T object; //!< Object associated with the key.
+  unsigned int level; //!< how many forward pointers there are.
+  unsigned char state; //!< NodeState flags.  Fits in the padding before pointers.
+  unsigned char room; //!< Pointer levels allocated.  rebalance() may leave level below it.
+  ptr_type pointers[1];
+  ForwardNode<T>*& forward(unsigned int level) {return pointers[level];}
+  ForwardNode<T>* forward(unsigned int level) const {return pointers[level];}
+  ForwardNode(unsigned int level, const T &obj) : object(obj), level(level), state(0), room((unsigned char)level) CSClearNodesForward
+  explicit ForwardNode(unsigned int level) : level(level), state(0), room((unsigned char)level) CSClearNodesForward
+};
+
 // Contains forward and backward pointers only.
 template <class T>
 class BidiNode
@@ -144,14 +292,62 @@ public:
   typedef Pointers ptr_type;
 
   T object; //!< Object associated with the key.
-  unsigned int level; //!< how many forward and backward pointers there are.
+  unsigned char level; //!< how many forward and backward pointers there are.  A byte, like room; CSInitCore keeps maxLevel within it.
+  unsigned char state; //!< NodeState flags.  Fits in the padding before pointers.
+  unsigned char room; //!< Pointer levels allocated.  rebalance() may leave level below it.
   ptr_type pointers[1];
   BidiNode<T>*& forward(unsigned int level) {return pointers[level].forward;}
   BidiNode<T>*& backward(unsigned int level) {return pointers[level].backward;}
   BidiNode<T>* forward(unsigned int level) const {return pointers[level].forward;}
   BidiNode<T>* backward(unsigned int level) const {return pointers[level].backward;}
-  BidiNode(unsigned int level, const T &obj) : level(level), object(obj) CSClearNodesBidi
-  explicit BidiNode(unsigned int level) : level(level) CSClearNodesBidi
+  BidiNode(unsigned int level, const T &obj) : object(obj), level(level), state(0), room((unsigned char)level) CSClearNodesBidi
+  explicit BidiNode(unsigned int level) : level(level), state(0), room((unsigned char)level) CSClearNodesBidi
+};
+
+// BidiNode that also counts lookups, for access-adaptive skiplists.
+// base and hits sit in the padding after state, so the node is no larger.
+template <class T>
+class AdaptiveBidiNode
+{
+public:
+  typedef size_t size_type;
+  struct Pointers
+  {
+    AdaptiveBidiNode<T> *forward;
+    AdaptiveBidiNode<T> *backward;
+  };
+  typedef Pointers ptr_type;
+
+  T object; //!< Object associated with the key.
+  unsigned int level; //!< how many forward and backward pointers there are.
+  unsigned char state; //!< NodeState flags.
+  unsigned char base; //!< Level drawn at insert time, kept when the node is relevelled.
+  unsigned short hits; //!< Saturating lookup count, halved by every adapt().
+  ptr_type pointers[1];
+  AdaptiveBidiNode<T>*& forward(unsigned int level) {return pointers[level].forward;}
+  AdaptiveBidiNode<T>*& backward(unsigned int level) {return pointers[level].backward;}
+  AdaptiveBidiNode<T>* forward(unsigned int level) const {return pointers[level].forward;}
+  AdaptiveBidiNode<T>* backward(unsigned int level) const {return pointers[level].backward;}
+  AdaptiveBidiNode(unsigned int level, const T &obj) : object(obj), level(level), state(0), base((unsigned char)(level<255 ? level : 255)), hits(0) CSClearNodesBidi
+  explicit AdaptiveBidiNode(unsigned int level) : level(level), state(0), base(0), hits(0) CSClearNodesBidi
+};
+
+// Snapshot of a skiplist's shape, filled by stats().
+struct SkipListStats
+{
+  size_t items;
+  unsigned int level;    //!< Highest level in use.
+  unsigned int maxLevel; //!< Highest level possible.
+  std::vector<size_t> nodesPerLevel; //!< nodesPerLevel[i] is the number of nodes whose top level is i.
+  size_t sampled;        //!< Number of keys searched for the path lengths.
+  double averagePath;    //!< Pointers followed per search, across and down.
+  size_t maxPath;
+  size_t nodeBytes;      //!< Bytes allocated for the nodes holding items.
+  size_t pointerBytes;   //!< Part of nodeBytes used by the pointers.
+  size_t sentinelBytes;  //!< Bytes allocated for head and tail.
+  size_t updateBytes;    //!< Size of the update array.
+  size_t filterBytes;    //!< Size of the membership filter, 0 when there is none.
+  size_t deadNodes;      //!< Erased nodes still linked, waiting for compact().
 };
 
 // Allocates node
@@ -181,13 +377,23 @@ public:
   return item; \
 }
 
+// Pointer levels a node was allocated with.  Nodes that can be relevelled
+// in place remember it; for the others it is their level.
+template <class N>
+unsigned int NodeRoom(const N *node) {return node->level;}
+template <class T>
+unsigned int NodeRoom(const ForwardNode<T> *node) {return node->room;}
+template <class T>
+unsigned int NodeRoom(const BidiNode<T> *node) {return node->room;}
+
 // Free a node.
 #define CSFree(alloc, item, Tp) \
 { \
+  unsigned int room = NodeRoom(item); \
   typename alloc::template rebind<Tp>::other aTp; \
   aTp.destroy(item); \
   typename alloc::template rebind<char>::other aChar; \
-  aChar.deallocate(reinterpret_cast<char*>(item), sizeof(Tp) + item->level*sizeof(typename Tp::ptr_type)); \
+  aChar.deallocate(reinterpret_cast<char*>(item), sizeof(Tp) + room*sizeof(typename Tp::ptr_type)); \
 }
 
 // Defines operators == and != for iterators.
@@ -215,6 +421,7 @@ public:
       if ((node != NULL)&&((node1 = node->forward(0)) != NULL)) \
       { \
         node = node1; \
+CSLAZY(while (node->state&node_dead) node = node->forward(0);,) \
 CSINDEX(Findex++,); \
       } \
       return *this; \
@@ -245,11 +452,14 @@ CSINDEX(Findex++,); \
     it& operator--() \
     { \
       node_type* node1; \
-      node_type* node2; \
-      if ((node != NULL)&&((node1 = node->backward(0)) != NULL)&&((node2 = node1->backward(0)) != NULL)) \
+      if ((node != NULL)&&((node1 = node->backward(0)) != NULL)) \
       { \
-        node = node1; \
+CSLAZY(while (node1->state&node_dead) node1 = node1->backward(0);,) \
+        if (node1->backward(0) != NULL) \
+        { \
+          node = node1; \
 CSINDEX(Findex--,); \
+        } \
       } \
       return *this; \
     } \
@@ -640,10 +850,602 @@ CSLEVEL(if (off<0) return operator+=(-off); \
     }
 
 
+// Drops a node's key from the membership filter before the node is freed.
+#define CSFilterErase(node) \
+CSFILTER(if (bloom!=NULL) bloom->erase(key((node)->object));,)
+
+// Optional approximate membership filter checked by find() and count().
+// A miss in the filter answers without descending the list.
+#define CSDefineFilter \
+void enable_filter(size_type expectedItems, double falsePositiveRate = 0.01) \
+{ \
+  filter_type *f = new filter_type(expectedItems, falsePositiveRate); \
+  for(node_type *node=head->forward(0);node!=tail;node=node->forward(0)) \
+  { \
+CSLAZY(if (node->state&node_dead) continue;,) \
+    f->insert(key(node->object)); \
+  } \
+  delete bloom; \
+  bloom = f; \
+} \
+ \
+void disable_filter() \
+{ \
+  delete bloom; \
+  bloom = NULL; \
+} \
+ \
+const filter_type* filter() const \
+{ \
+  return bloom; \
+}
+
+// Splits the list into at most 'parts' consecutive ranges of roughly equal
+// size.  Boundaries are taken from the highest level that has about eight
+// nodes per range, since the nodes of a level are spread evenly through
+// the list.
+#define CSDefineSplit \
+void split_nodes(size_type parts, std::vector<node_type*> &bounds) const \
+{ \
+  bounds.clear(); \
+  if (size()==0) return; \
+  if (parts<1) parts = 1; \
+ \
+  size_type count = 0; \
+  int i=level; \
+  for(;i>=0;i--) \
+  { \
+    count = 0; \
+    for(node_type *node=head->forward(i);node!=tail;node=node->forward(i)) count++; \
+    if (count>=parts*8) break; \
+  } \
+  if (i<0) i = 0; \
+  if (parts>count) parts = count; \
+ \
+  bounds.push_back(CSLAZY(Live(head->forward(0)),head->forward(0))); \
+  size_type pos = 0; \
+  size_type next = 1; \
+  for(node_type *node=head->forward(i);(node!=tail)&&(next<parts);node=node->forward(i),pos++) \
+  { \
+    if ((pos>0)&&(pos>=next*count/parts)) \
+    { \
+      /* A dead boundary moves to the next live node.  Ranges that end */ \
+      /* up empty are dropped. */ \
+      node_type *bound = CSLAZY(Live(node),node); \
+      if ((bound!=tail)&&(bound!=bounds.back())) bounds.push_back(bound); \
+      next++; \
+    } \
+  } \
+  bounds.push_back(tail); \
+} \
+ \
+std::vector<ipair> split(size_type parts) \
+{ \
+  std::vector<node_type*> bounds; \
+  split_nodes(parts, bounds); \
+  std::vector<ipair> ranges; \
+  for(size_type i=1;i<bounds.size();i++) \
+  { \
+    ranges.push_back(ipair(iterator(this,bounds[i-1]),iterator(this,bounds[i]))); \
+  } \
+  return ranges; \
+} \
+ \
+std::vector<const_ipair> split(size_type parts) const \
+{ \
+  std::vector<node_type*> bounds; \
+  split_nodes(parts, bounds); \
+  std::vector<const_ipair> ranges; \
+  for(size_type i=1;i<bounds.size();i++) \
+  { \
+    ranges.push_back(const_ipair(const_iterator(this,bounds[i-1]),const_iterator(this,bounds[i]))); \
+  } \
+  return ranges; \
+}
+
+// Replaces the contents with **first, **(first+1), ... which must be sorted
+// by key with no duplicates.  Levels are drawn on the calling thread, then
+// 'pool' (anything with size(), submit() and wait()) allocates and links
+// consecutive chunks concurrently, and the chunks are stitched together one
+// level at a time.  The allocator must be safe to use from several threads.
+#define CSDefineAssignSorted \
+template<class PtrIt, class Pool> void assign_sorted(PtrIt first, PtrIt last, Pool &pool) \
+{ \
+  clear(); \
+  size_type n = last-first; \
+  if (n==0) return; \
+ \
+  std::vector<unsigned int> levels(n); \
+  unsigned int top = 0; \
+  for(size_type i=0;i<n;i++) \
+  { \
+    levels[i] = GenerateRandomLevel(); \
+    if (levels[i]>top) top = levels[i]; \
+  } \
+ \
+  size_type parts = pool.size()*4; \
+  if (parts>(n+1023)/1024) parts = (n+1023)/1024; \
+  size_type width = top+1; \
+  std::vector<node_type*> firsts(parts*width, NULL); \
+  std::vector<node_type*> lasts(parts*width, NULL); \
+  for(size_type c=0;c<parts;c++) \
+  { \
+    pool.submit([this,c,n,parts,width,first,&levels,&firsts,&lasts]() \
+    { \
+      node_type **f = &firsts[c*width]; \
+      node_type **l = &lasts[c*width]; \
+      for(size_type i=c*n/parts;i<(c+1)*n/parts;i++) \
+      { \
+        node_type *node = Alloc(levels[i], **(first+i)); \
+        for(unsigned int j=0;j<=levels[i];j++) \
+        { \
+          if (l[j]!=NULL) \
+          { \
+            l[j]->forward(j) = node; \
+CSBIDI(     node->backward(j) = l[j];,) \
+          } \
+          else f[j] = node; \
+          l[j] = node; \
+        } \
+      } \
+    }); \
+  } \
+  try \
+  { \
+    pool.wait(); \
+  } \
+  catch(...) \
+  { \
+    for(size_type c=0;c<parts;c++) \
+    { \
+      node_type *node = firsts[c*width]; \
+      while (node!=NULL) \
+      { \
+        node_type *next = (node==lasts[c*width]) ? NULL : node->forward(0); \
+        Free(node); \
+        node = next; \
+      } \
+    } \
+    throw; \
+  } \
+ \
+  for(unsigned int j=0;j<=top;j++) \
+  { \
+    node_type *prev = head; \
+    for(size_type c=0;c<parts;c++) \
+    { \
+      node_type *f = firsts[c*width+j]; \
+      if (f==NULL) continue; \
+      prev->forward(j) = f; \
+CSBIDI(f->backward(j) = prev;,) \
+      prev = lasts[c*width+j]; \
+    } \
+    prev->forward(j) = tail; \
+CSBIDI(tail->backward(j) = prev;,) \
+  } \
+  level = top; \
+CSLEVEL(head->level = top;,) \
+CSLEVEL(tail->level = top;,) \
+  items = n; \
+CSFILTER(if (bloom!=NULL) \
+  { \
+    for(node_type *node=head->forward(0);node!=tail;node=node->forward(0)) bloom->insert(key(node->object)); \
+  },) \
+}
+
+// Inserts [first,last) in any order.  The batch is copied and sorted by key,
+// then merged into the list in one pass: update[] keeps the predecessors of
+// the previous key, so each key climbs only as high as the list has moved
+// since and walks down from there instead of from head.  Keys already in the
+// list, and later copies of a key within the batch, are skipped as insert()
+// would skip them.  Nodes already in the list are only written to when a new
+// node is linked next to them.  Returns the number of keys added.
+#define CSDefineInsertBatch \
+template<class InIt> size_type insert_batch(InIt first, InIt last) \
+{ \
+  value_compare ValueComp = value_comp(); \
+ \
+  std::vector<value_type> batch(first, last); \
+  std::vector<const value_type*> order(batch.size()); \
+  for(size_type i=0;i<batch.size();i++) order[i] = &batch[i]; \
+  std::stable_sort(order.begin(), order.end(), [&ValueComp](const value_type *a, const value_type *b) { return ValueComp(*a, *b); }); \
+ \
+  for(size_type i=0;i<=level;i++) update[i].second = head; \
+ \
+  size_type added = 0; \
+  for(size_type b=0;b<order.size();b++) \
+  { \
+    const value_type &val = *order[b]; \
+CSUNIQUE(    if ((b>0)&&(!ValueComp(*order[b-1],val))) continue;,) \
+ \
+    /* Levels whose next node is still below val form a prefix. */ \
+    size_type top = 0; \
+    while ((top<=level)&&(update[top].second->forward(top)!=tail)&&(ValueComp(update[top].second->forward(top)->object,val))) top++; \
+ \
+    node_type *node = (top>0) ? update[top-1].second : head; \
+    for (size_type i=top; i-->0;) \
+    { \
+      node_type *node1 = node->forward(i); \
+      while ((node1!=tail)&&(ValueComp(node1->object,val))) \
+      { \
+        node = node1; \
+        node1 = node1->forward(i); \
+      } \
+      update[i].second = node; \
+    } \
+ \
+CSUNIQUE(    node_type *next = update[0].second->forward(0);,) \
+CSUNIQUE(    if ((next!=tail)&&(!ValueComp(val,next->object))) \
+    { \
+CSLAZY(      if (next->state&node_dead) { Revive(next,val); added++; },) \
+      continue; \
+    },) \
+ \
+    unsigned int newLevel = GenerateRandomLevel(); \
+    node_type *cursor = Alloc(newLevel, val); \
+ \
+    if (newLevel > level) \
+    { \
+      for (size_type i=level+1;i<=newLevel;i++) \
+      { \
+        head->forward(i) = tail; \
+CSBIDI(        tail->backward(i) = head;,) \
+        update[i].second = head; \
+      } \
+      level = newLevel; \
+      head->level = newLevel; \
+      tail->level = newLevel; \
+    } \
+ \
+    for (unsigned int i=0; i<=newLevel; i++) \
+    { \
+CSBIDI(      cursor->backward(i) = update[i].second;,) \
+      cursor->forward(i) = update[i].second->forward(i); \
+CSBIDI(      cursor->forward(i)->backward(i) = cursor;,) \
+      update[i].second->forward(i) = cursor; \
+      update[i].second = cursor; \
+    } \
+CSFILTER(    if (bloom!=NULL) bloom->insert(key(val));,) \
+    items++; \
+    added++; \
+  } \
+  return added; \
+}
+
+// Fills a SkipListStats in one pass over level 0.  Path lengths come from
+// searching for every (size()/samples)th key the way find() does.
+#define CSDefineStats \
+SkipListStats stats(size_type samples = 1024) const \
+{ \
+  typedef typename node_type::ptr_type ptr_type; \
+  key_compare KeyComp = key_comp(); \
+  SkipListStats s; \
+  s.items = size(); \
+  s.level = (unsigned int)level; \
+  s.maxLevel = (unsigned int)maxLevel; \
+  s.nodesPerLevel.assign(maxLevel+1, 0); \
+  s.sampled = 0; \
+  s.maxPath = 0; \
+  s.nodeBytes = 0; \
+  s.pointerBytes = 0; \
+ \
+  size_type stride = (samples==0) ? 0 : (items+samples-1)/samples; \
+  size_type pos = 0; \
+  size_type totalPath = 0; \
+  for(node_type *node=head->forward(0);node!=tail;node=node->forward(0),pos++) \
+  { \
+    s.nodesPerLevel[node->level]++; \
+    /* rebalance() can leave level below the room allocated. */ \
+    s.nodeBytes += sizeof(node_type)+NodeRoom(node)*sizeof(ptr_type); \
+    s.pointerBytes += (NodeRoom(node)+1)*sizeof(ptr_type); \
+    if ((stride==0)||(pos%stride!=0)) continue; \
+ \
+    /* One step per drop to a lower level and one per pointer followed. */ \
+    size_type path = level+1; \
+    node_type *cursor = head; \
+    for(int i=level;i>=0;i--) \
+    { \
+      node_type *node1 = cursor->forward(i); \
+      while ((node1!=tail)&&(KeyComp(key(node1->object),key(node->object)))) \
+      { \
+        cursor = node1; \
+        node1 = node1->forward(i); \
+        path++; \
+      } \
+    } \
+    totalPath += path; \
+    if (path>s.maxPath) s.maxPath = path; \
+    s.sampled++; \
+  } \
+  s.averagePath = (s.sampled==0) ? 0.0 : (double)totalPath/(double)s.sampled; \
+  s.sentinelBytes = 2*(sizeof(node_type)+maxLevel*sizeof(ptr_type)); \
+  s.updateBytes = (maxLevel+1)*sizeof(update[0]); \
+  s.filterBytes = CSFILTER((bloom==NULL) ? 0 : bloom->memory_usage(),0); \
+  s.deadNodes = CSLAZY(tombstones,0); \
+  return s; \
+}
+
+// Lazy deletion.  While lazy_erase(true) is set, erase() only marks a node
+// dead and lists it in the graveyard.  Searches and iterators step over dead
+// nodes, inserting a dead key revives its node in place, and compact()
+// unlinks and frees them in batches through their backward pointers.
+// These are the private helpers.
+#define CSDefineLazyNodes \
+node_type* Live(node_type *node) const \
+{ \
+  while (node->state&node_dead) node = node->forward(0); \
+  return node; \
+} \
+ \
+node_type* LiveBefore(node_type *node) const \
+{ \
+  node = node->backward(0); \
+  while (node->state&node_dead) node = node->backward(0); \
+  return node; \
+} \
+ \
+/* Last live node for lists without backward pointers.  Cheap unless the */ \
+/* last node is dead, which needs a walk along level 0. */ \
+node_type* LiveBack() const \
+{ \
+  scan(tail); \
+  if (!(update[0].second->state&node_dead)) return update[0].second; \
+  node_type *last = head; \
+  for(node_type *node=head->forward(0);node!=tail;node=node->forward(0)) \
+  { \
+    if (!(node->state&node_dead)) last = node; \
+  } \
+  return last; \
+} \
+ \
+void Kill(node_type *node) \
+{ \
+  if (node->state&node_dead) return; \
+  if (!(node->state&node_queued)) \
+  { \
+    graveyard.push_back(node); \
+    node->state |= node_queued; \
+  } \
+CSFilterErase(node) \
+  node->state |= node_dead; \
+  tombstones++; \
+} \
+ \
+node_type* Revive(node_type *node, const value_type &val) \
+{ \
+  value(node->object) = value(val); \
+  node->state &= ~node_dead; \
+  tombstones--; \
+CSFILTER(if (bloom!=NULL) bloom->insert(key(val));,) \
+  return node; \
+}
+
+// Public side of lazy deletion.  Turning it off compacts everything, so
+// only a lazy container ever holds dead nodes.
+#define CSDefineLazy \
+void lazy_erase(bool enable) \
+{ \
+  if (!enable) compact(); \
+  lazy = enable; \
+} \
+ \
+bool lazy_erase() const \
+{ \
+  return lazy; \
+} \
+ \
+size_type tombstone_count() const \
+{ \
+  return tombstones; \
+} \
+ \
+/* Frees up to 'batch' dead nodes and returns how many were freed. */ \
+size_type compact(size_type batch = (size_type)-1) \
+{ \
+  size_type freed = 0; \
+  while ((batch>0)&&(!graveyard.empty())) \
+  { \
+    node_type *node = graveyard.back(); \
+    graveyard.pop_back(); \
+    batch--; \
+    node->state &= ~node_queued; \
+    if (!(node->state&node_dead)) continue; \
+ \
+CSBIDI(for(unsigned int i=0;i<=node->level;i++) \
+    { \
+      node->backward(i)->forward(i) = node->forward(i); \
+      node->forward(i)->backward(i) = node->backward(i); \
+    }, \
+    /* No backward pointers, so search for the node's predecessors. */ \
+    scan_key(key(node->object)); \
+    for(unsigned int i=0;i<=node->level;i++) update[i].second->forward(i) = node->forward(i);) \
+    Free(node); \
+    items--; \
+    tombstones--; \
+    freed++; \
+  } \
+  if (freed>0) adjust_levels(); \
+  return freed; \
+}
+
+// Access-biased levels.  Non-const find() counts hits on the node it
+// returns; find() const leaves the nodes alone so that concurrent readers
+// under a shared lock do not race.  adapt() gives every node the higher of
+// its base level and log_{1/p}(hits*n/totalHits), so a key's search cost
+// follows its share of the lookups rather than log n.  Nodes that cooled
+// off drop back to their base level, and all counts are halved so old
+// traffic fades out.
+// Nodes whose level changes are reallocated, which invalidates iterators
+// to them.  Dead nodes keep their level.
+#define CSDefineAdapt \
+void adapt() \
+{ \
+  if (items==0) return; \
+ \
+  double total = 0; \
+  for(node_type *node=head->forward(0);node!=tail;node=node->forward(0)) total += node->hits; \
+  double scale = (total>0) ? (double)items/total : 0.0; \
+  double logp = log(1.0/probability); \
+ \
+  /* Allocate the replacements first so a failure leaves the list intact. */ \
+  std::vector<node_type*> last(maxLevel+1, head); \
+  std::vector<std::pair<node_type*,node_type*> > moved; \
+  try \
+  { \
+    for(node_type *node=head->forward(0);node!=tail;node=node->forward(0)) \
+    { \
+      if (node->state!=0) continue; \
+      unsigned int newLevel = node->base; \
+      double share = node->hits*scale; \
+      if (share>1.0) \
+      { \
+        unsigned int boost = (unsigned int)(log(share)/logp); \
+        if (boost>newLevel) newLevel = boost; \
+      } \
+      if (newLevel>maxLevel) newLevel = (unsigned int)maxLevel; \
+      if (newLevel==node->level) continue; \
+ \
+      node_type *copy = Alloc(newLevel, node->object); \
+      copy->base = node->base; \
+      copy->hits = node->hits; \
+      moved.push_back(std::pair<node_type*,node_type*>(node, copy)); \
+    } \
+  } \
+  catch(...) \
+  { \
+    for(size_type i=0;i<moved.size();i++) Free(moved[i].second); \
+    throw; \
+  } \
+ \
+  /* Swap the copies in and relink every level in one pass. */ \
+  unsigned int top = 0; \
+  size_type m = 0; \
+  for(node_type *node=head->forward(0);node!=tail;) \
+  { \
+    node_type *next = node->forward(0); \
+    if ((m<moved.size())&&(moved[m].first==node)) \
+    { \
+      Free(node); \
+      node = moved[m++].second; \
+    } \
+    node->hits >>= 1; \
+    for(unsigned int i=0;i<=node->level;i++) \
+    { \
+      last[i]->forward(i) = node; \
+      node->backward(i) = last[i]; \
+      last[i] = node; \
+    } \
+    if (node->level>top) top = node->level; \
+    node = next; \
+  } \
+  for(unsigned int i=0;i<=maxLevel;i++) \
+  { \
+    last[i]->forward(i) = tail; \
+    tail->backward(i) = last[i]; \
+  } \
+  level = top; \
+  head->level = top; \
+  tail->level = top; \
+}
+
+// Rebuilds the levels from ranks instead of coin flips.  The node at rank r,
+// counting from 1, gets the highest level k for which spacing^k divides r,
+// where spacing is 1/probability rounded.  Promotions end up evenly spaced on
+// every level, so a search follows at most spacing-1 pointers per level.
+// Everything is relinked in one pass along level 0.  A node keeps its memory
+// when the new level fits in the pointers it was allocated with.  Otherwise
+// it is copied into a taller node, which invalidates iterators to it.
+// rebalance(first, count, rank) does one segment of count nodes, first being
+// at position rank, and returns where the next segment starts, so a long
+// list can be rebalanced a little at a time between other work.
+#define CSDefineRebalance \
+void rebalance() \
+{ \
+CSLAZY(compact();,) \
+  rebalance(begin(), items, 0); \
+  adjust_levels(); \
+} \
+ \
+iterator rebalance(iterator first, size_type count, size_type rank) \
+{ \
+  node_type *start = first.node; \
+  if ((start==tail)||(count==0)) return first; \
+  size_type spacing = (size_type)(1.0/probability+0.5); \
+  if (spacing<2) spacing = 2; \
+ \
+  /* last[i] is the node before the segment on level i and after[i] the */ \
+  /* first one behind it, found while walking the old segment.  Above */ \
+  /* level the head's links may be stale, so after[i] stays tail there. */ \
+  std::vector<node_type*> last(maxLevel+1, head); \
+  std::vector<node_type*> after(maxLevel+1, tail); \
+  scan_key(key(start->object)); \
+  for(unsigned int i=0;i<=level;i++) \
+  { \
+    last[i] = update[i].second; \
+    after[i] = last[i]->forward(i); \
+  } \
+ \
+  /* Allocate the nodes that have to grow before touching any link, so a */ \
+  /* failure leaves the list intact.  Dead or queued nodes stay put. */ \
+  std::vector<unsigned int> levels; \
+  std::vector<std::pair<node_type*,node_type*> > moved; \
+  try \
+  { \
+    for(node_type *node=start;(node!=tail)&&(levels.size()<count);node=node->forward(0)) \
+    { \
+      unsigned int newLevel = 0; \
+      for(size_type r=rank+levels.size()+1;(r%spacing==0)&&(newLevel<maxLevel);r/=spacing) newLevel++; \
+      for(unsigned int i=0;i<=node->level;i++) after[i] = node->forward(i); \
+      if (newLevel>NodeRoom(node)) \
+      { \
+        if (node->state!=0) newLevel = NodeRoom(node); \
+        else moved.push_back(std::pair<node_type*,node_type*>(node, Alloc(newLevel, node->object))); \
+      } \
+      levels.push_back(newLevel); \
+    } \
+  } \
+  catch(...) \
+  { \
+    for(size_type i=0;i<moved.size();i++) Free(moved[i].second); \
+    throw; \
+  } \
+ \
+  unsigned int top = 0; \
+  size_type m = 0; \
+  node_type *node = start; \
+  for(size_type j=0;j<levels.size();j++) \
+  { \
+    node_type *next = node->forward(0); \
+    if ((m<moved.size())&&(moved[m].first==node)) \
+    { \
+      Free(node); \
+      node = moved[m++].second; \
+    } \
+    node->level = levels[j]; \
+    for(unsigned int i=0;i<=node->level;i++) \
+    { \
+      last[i]->forward(i) = node; \
+CSBIDI(node->backward(i) = last[i];,) \
+      last[i] = node; \
+    } \
+    if (node->level>top) top = node->level; \
+    node = next; \
+  } \
+  for(unsigned int i=0;i<=maxLevel;i++) \
+  { \
+    last[i]->forward(i) = after[i]; \
+CSBIDI(after[i]->backward(i) = last[i];,) \
+  } \
+  if (top>level) level = top; \
+CSLEVEL(head->level = level; \
+  tail->level = level;,) \
+  return iterator(this, node); \
+}
+
 #define CSDefineBeginEnd \
 iterator begin() \
 { \
-  return CSINDEX(iterator(this,head->forward(0),0),iterator(this,head->forward(0))); \
+  return CSINDEX(iterator(this,head->forward(0),0),iterator(this,CSLAZY(Live(head->forward(0)),head->forward(0)))); \
 } \
  \
 iterator end() \
@@ -653,7 +1455,7 @@ iterator end() \
  \
 const_iterator begin() const \
 { \
-  return CSINDEX(const_iterator(this,head->forward(0),0),const_iterator(this,head->forward(0))); \
+  return CSINDEX(const_iterator(this,head->forward(0),0),const_iterator(this,CSLAZY(Live(head->forward(0)),head->forward(0)))); \
 } \
  \
 const_iterator end() const \
@@ -685,46 +1487,41 @@ const_reverse_iterator rend() const \
 #define CSDefineGenerateRandomLevel \
 unsigned int GenerateRandomLevel() \
 { \
-  unsigned int newLevel = 0; \
-  while ((newLevel<maxLevel)&&(rng.drand()<probability)) \
-  { \
-    newLevel++; \
-  } \
-  return newLevel; \
+  return level_generator::draw(rng, probability, maxLevel); \
 }
 
 #define CSDefineSize \
 size_type size() const \
 { \
-  return items; \
+  return items CSLAZY(-tombstones,); \
 }
 
 #define CSDefineEmpty \
 bool empty() const \
 { \
-  return (items==0); \
+  return (items CSLAZY(-tombstones,)==0); \
 }
 
 #define CSDefineFront \
 reference front() \
 { \
-  return head->forward(0)->object; \
+  return CSLAZY(Live(head->forward(0)),head->forward(0))->object; \
 } \
  \
 const_reference front() const \
 { \
-  return head->forward(0)->object; \
+  return CSLAZY(Live(head->forward(0)),head->forward(0))->object; \
 }
 
 #define CSDefineBackBidi \
 reference back() \
 { \
-  return tail->backward(0)->object; \
+  return CSLAZY(LiveBefore(tail),tail->backward(0))->object; \
 } \
  \
 const_reference back() const \
 { \
-  return tail->backward(0)->object; \
+  return CSLAZY(LiveBefore(tail),tail->backward(0))->object; \
 }
 
 #define CSDefineBackForward \
@@ -733,6 +1530,7 @@ reference back() \
 CSINDEX(if (scan_index==items) return update[0].second->object,); \
 CSINDEX(if ((scan_index==items-1)&&(scan_index!=-1)) return update[0].second->forward(0)->object,); \
  \
+CSLAZY(if (tombstones>0) return LiveBack()->object;,) \
 CSINDEX(scan(items-1),scan(tail)); \
  \
 return CSINDEX(update[0].second->forward(0)->object,update[0].second->object); \
@@ -743,6 +1541,7 @@ const_reference back() const \
 CSINDEX(if (scan_index==items) return update[0].second->object,); \
 CSINDEX(if ((scan_index==items-1)&&(scan_index!=-1)) return update[0].second->forward(0)->object,); \
  \
+CSLAZY(if (tombstones>0) return LiveBack()->object;,) \
 CSINDEX(scan(items-1),scan(tail)); \
  \
   return CSINDEX(update[0].second->forward(0)->object,update[0].second->object); \
@@ -817,6 +1616,9 @@ void clear() \
 CSINDEX(head->skip(0) = 1,); \
   head->forward(0) = tail; \
 CSBIDI(tail->backward(0) = head,); \
+CSFILTER(if (bloom!=NULL) bloom->clear();,) \
+CSLAZY(graveyard.clear(); \
+  tombstones = 0;,) \
  \
   level = 0; \
   items = 0; \
@@ -829,6 +1631,7 @@ CSINDEX(scan_index = -1,); \
 #define CSDefineDestroy \
 void destroy() \
 { \
+CSLAZY(compact();,) \
   node_type *t1,*t2; \
   t1 = head->forward(0); \
   while((t1)&&(t1!=tail)) \
@@ -842,6 +1645,7 @@ void destroy() \
 CSINDEX(head->skip(0) = 1,); \
   head->forward(0) = tail; \
 CSBIDI(tail->backward(0) = head,); \
+CSFILTER(if (bloom!=NULL) bloom->clear();,) \
  \
   level = 0; \
   items = 0; \
@@ -855,64 +1659,169 @@ CSINDEX(scan_index = -1,); \
 iterator find(const key_type& keyval) \
 { \
   node_type *cursor = head; \
+CSFILTER(if ((bloom!=NULL)&&(!bloom->contains(keyval))) return end();,) \
   key_compare KeyComp = key_comp(); \
 CSINDEX(size_type pos = -1,); \
  \
+  /* With an exact key_order one comparison per node both steps past */ \
+  /* smaller keys and spots the match, which ends the search early. */ \
+  node_type *match = NULL; \
   for(int i=level;i>=0;i--) \
   { \
     node_type *node1 = cursor->forward(i); \
-    while ((node1!=tail)&&(KeyComp(key(node1->object),keyval))) \
+    int order = 1; \
+    while ((node1!=tail)&&((order = key_order::order(KeyComp,key(node1->object),keyval))<0)) \
     { \
 CSINDEX(pos += cursor->skip(i),); \
       cursor = node1; \
       node1 = node1->forward(i); \
     } \
+    if ((order==0)&&(node1!=tail)) \
+    { \
+CSINDEX(pos += cursor->skip(i),); \
+      match = node1; \
+      break; \
+    } \
+CSADAPT(/* Hot keys sit high up, so stop as soon as the key is met. */ \
+    if ((!key_order::exact)&&(node1!=tail)&&(!KeyComp(keyval,key(node1->object)))) \
+    { \
+      match = node1; \
+      break; \
+    },) \
   } \
  \
-CSINDEX(pos += cursor->skip(0),); \
-  cursor = cursor->forward(0); \
- \
-  if ((cursor==tail)||(KeyComp(keyval,key(cursor->object)))) \
+  if (match==NULL) \
   { \
-    /* Match not found. */ \
-    return end(); \
+CSINDEX(pos += cursor->skip(0),); \
+    cursor = cursor->forward(0); \
+    if ((key_order::exact)||(cursor==tail)||(KeyComp(keyval,key(cursor->object)))) \
+    { \
+      /* Match not found. */ \
+      return end(); \
+    } \
+    match = cursor; \
   } \
+CSLAZY(if (match->state&node_dead) return end();,) \
  \
-  return CSINDEX(iterator(this,cursor,pos),iterator(this,cursor)); \
+CSADAPT(if (match->hits<0xFFFF) match->hits++;,) \
+  return CSINDEX(iterator(this,match,pos),iterator(this,match)); \
 } \
  \
 const_iterator find(const key_type& keyval) const \
 { \
   node_type *cursor = head; \
+CSFILTER(if ((bloom!=NULL)&&(!bloom->contains(keyval))) return end();,) \
   key_compare KeyComp = key_comp(); \
 CSINDEX(size_type pos = -1,); \
  \
+  /* With an exact key_order one comparison per node both steps past */ \
+  /* smaller keys and spots the match, which ends the search early. */ \
+  node_type *match = NULL; \
   for(int i=level;i>=0;i--) \
   { \
     node_type *node1 = cursor->forward(i); \
-    while ((node1!=tail)&&(KeyComp(key(node1->object),keyval))) \
+    int order = 1; \
+    while ((node1!=tail)&&((order = key_order::order(KeyComp,key(node1->object),keyval))<0)) \
     { \
 CSINDEX(pos += cursor->skip(i),); \
       cursor = node1; \
       node1 = node1->forward(i); \
     } \
+    if ((order==0)&&(node1!=tail)) \
+    { \
+CSINDEX(pos += cursor->skip(i),); \
+      match = node1; \
+      break; \
+    } \
+CSADAPT(/* Hot keys sit high up, so stop as soon as the key is met. */ \
+    if ((!key_order::exact)&&(node1!=tail)&&(!KeyComp(keyval,key(node1->object)))) \
+    { \
+      match = node1; \
+      break; \
+    },) \
   } \
  \
+  if (match==NULL) \
+  { \
 CSINDEX(pos += cursor->skip(0),); \
-  cursor = cursor->forward(0); \
+    cursor = cursor->forward(0); \
+    if ((key_order::exact)||(cursor==tail)||(KeyComp(keyval,key(cursor->object)))) \
+    { \
+      /* Match not found. */ \
+      return end(); \
+    } \
+    match = cursor; \
+  } \
+CSLAZY(if (match->state&node_dead) return end();,) \
  \
-  if ((cursor==tail)||(KeyComp(keyval,key(cursor->object)))) \
+  return CSINDEX(const_iterator(this,match,pos),const_iterator(this,match)); \
+}
+
+#if defined(__GNUC__)
+#define CSPrefetch(p) __builtin_prefetch(p)
+#else
+#define CSPrefetch(p)
+#endif
+
+// find() split into steps for interleaving many lookups.  find_begin() sets
+// up a search, every find_step() follows one pointer and prefetches the node
+// it will look at next, and returns true once the search has reached level
+// 0.  find_end() then gives what find() would have returned.  A caller keeps
+// a group of searches going and steps each in turn, so their cache misses
+// overlap instead of following one another.
+#define CSDefineFindSteps \
+struct find_state \
+{ \
+  node_type *cursor; \
+  node_type *next; \
+  int i; \
+}; \
+ \
+void find_begin(find_state &s, const key_type& keyval) const \
+{ \
+  s.cursor = head; \
+  s.i = (int)level; \
+  s.next = head->forward(level); \
+CSFILTER(if ((bloom!=NULL)&&(!bloom->contains(keyval))) \
   { \
-    /* Match not found. */ \
-    return end(); \
+    s.i = 0; \
+    s.next = tail; \
+  },(void)keyval;) \
+  CSPrefetch(s.next); \
+} \
+ \
+bool find_step(find_state &s, const key_type& keyval) const \
+{ \
+  if ((s.next!=tail)&&(key_comp()(key(s.next->object),keyval))) \
+  { \
+    s.cursor = s.next; \
+    s.next = s.next->forward(s.i); \
+    CSPrefetch(s.next); \
+    return false; \
   } \
  \
-  return CSINDEX(const_iterator(this,cursor,pos),const_iterator(this,cursor)); \
+  /* Levels that lead to the node just ruled out need no step of their own. */ \
+  node_type *stop = s.next; \
+  while ((s.i>0)&&(s.next==stop)) \
+  { \
+    s.i--; \
+    s.next = s.cursor->forward(s.i); \
+  } \
+  if (s.next==stop) return true; \
+  CSPrefetch(s.next); \
+  return false; \
+} \
+ \
+const_iterator find_end(const find_state &s, const key_type& keyval) const \
+{ \
+  if ((s.next==tail)||(key_comp()(keyval,key(s.next->object)))CSLAZY(||(s.next->state&node_dead),)) return end(); \
+  return const_iterator(this,s.next); \
 }
 
 #define CSDefineCount \
 size_type count(const key_type& keyval) const \
 { \
+CSFILTER(if ((bloom!=NULL)&&(!bloom->contains(keyval))) return 0;,) \
   const_iterator i = lower_bound(keyval); \
   const_iterator j = upper_bound(keyval); \
 CSINDEX(return j-i;, \
@@ -940,7 +1849,7 @@ CSINDEX(pos+=cursor->skip(i),); \
   } \
  \
 CSINDEX(pos+=cursor->skip(0),); \
-  cursor = cursor->forward(0); \
+  cursor = CSLAZY(Live(cursor->forward(0)),cursor->forward(0)); \
  \
   return CSINDEX(iterator(this,cursor,pos),iterator(this,cursor)); \
 } \
@@ -963,7 +1872,7 @@ CSINDEX(pos+=cursor->skip(i),); \
   } \
  \
 CSINDEX(pos+=cursor->skip(0),); \
-  cursor = cursor->forward(0); \
+  cursor = CSLAZY(Live(cursor->forward(0)),cursor->forward(0)); \
  \
   return CSINDEX(const_iterator(this,cursor,pos),const_iterator(this,cursor)); \
 }
@@ -987,7 +1896,7 @@ CSINDEX(pos += cursor->skip(i),); \
   } \
  \
 CSINDEX(pos+=cursor->skip(0),); \
-  cursor = cursor->forward(0); \
+  cursor = CSLAZY(Live(cursor->forward(0)),cursor->forward(0)); \
  \
   return CSINDEX(iterator(this,cursor,pos),iterator(this,cursor)); \
 } \
@@ -1010,7 +1919,7 @@ CSINDEX(pos += cursor->skip(i),); \
   } \
  \
 CSINDEX(pos+=cursor->skip(0),); \
-  cursor = cursor->forward(0); \
+  cursor = CSLAZY(Live(cursor->forward(0)),cursor->forward(0)); \
  \
   return CSINDEX(const_iterator(this,cursor,pos),const_iterator(this,cursor)); \
 }
@@ -1026,9 +1935,47 @@ const_ipair equal_range(const key_type& keyval) const \
   return const_ipair(lower_bound(keyval),upper_bound(keyval)); \
 }
 
+// Entries whose key starts with prefix, for string keys ordered by
+// std::less.  The range starts at lower_bound(prefix) and ends at
+// lower_bound() of PrefixSuccessor(prefix), so finding it costs two
+// searches however many entries it holds.  erase_prefix() removes the whole
+// range with one cut().
+#define CSDefinePrefix \
+ipair prefix_range(const key_type& prefix) \
+{ \
+  key_type next; \
+  iterator first = lower_bound(prefix); \
+  if (!PrefixSuccessor(prefix,next)) return ipair(first,end()); \
+  return ipair(first,lower_bound(next)); \
+} \
+ \
+const_ipair prefix_range(const key_type& prefix) const \
+{ \
+  key_type next; \
+  const_iterator first = lower_bound(prefix); \
+  if (!PrefixSuccessor(prefix,next)) return const_ipair(first,end()); \
+  return const_ipair(first,lower_bound(next)); \
+} \
+ \
+template<class Fn> Fn for_each_prefix(const key_type& prefix, Fn fun) \
+{ \
+  ipair range = prefix_range(prefix); \
+  for(iterator i=range.first;i!=range.second;++i) fun(*i); \
+  return fun; \
+} \
+ \
+size_type erase_prefix(const key_type& prefix) \
+{ \
+  ipair range = prefix_range(prefix); \
+  size_type before = size(); \
+  erase(range.first,range.second); \
+  return before-size(); \
+}
+
 #define CSDefinePopFront \
 void pop_front() \
 { \
+CSLAZY(if (lazy) { if (!empty()) erase(begin()); return; },) \
   if (items==0) return;  /* Can't delete anything if nothing's there. */ \
  \
 CSINDEX(scan_index = -1,); \
@@ -1055,6 +2002,7 @@ CSINDEX(for(;i<=level;i++) \
     head->skip(i)--; \
   },) \
  \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -1062,6 +2010,7 @@ CSINDEX(for(;i<=level;i++) \
  \
 void destroy_front() \
 { \
+CSLAZY(compact();,) \
   if (items==0) return;  /* Can't delete anything if nothing's there. */ \
  \
 CSINDEX(scan_index = -1,); \
@@ -1089,6 +2038,7 @@ CSINDEX(for(;i<=level;i++) \
   },) \
  \
   delete value(cursor->object); \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -1097,6 +2047,7 @@ CSINDEX(for(;i<=level;i++) \
 #define CSDefinePopBackBidi \
 void pop_back() \
 { \
+CSLAZY(if (lazy) { if (!empty()) erase(iterator(this,LiveBefore(tail))); return; },) \
   if (items==0) return;  /* Can't delete anything if nothing's there. */ \
  \
 CSINDEX(scan_index = -1,); \
@@ -1114,6 +2065,7 @@ CSINDEX(for(;i<=level;i++) \
     tail->backward(i)->skip(i)--; \
   },) \
  \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -1121,6 +2073,7 @@ CSINDEX(for(;i<=level;i++) \
  \
 void destroy_back() \
 { \
+CSLAZY(compact();,) \
   if (items==0) return;  /* Can't delete anything if nothing's there. */ \
  \
 CSINDEX(scan_index = -1;,) \
@@ -1139,6 +2092,7 @@ CSINDEX(for(;i<=level;i++) \
   },) \
  \
   delete value(cursor->object); \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -1262,6 +2216,7 @@ CSLEVEL(for(;i<=node->level;i++) \
 #define CSDefinePopBackForward \
 void pop_back() \
 { \
+CSLAZY(if (lazy) { if (!empty()) erase(iterator(this,LiveBack())); return; },) \
   if (items==0) return; \
  \
   node_type *cursor = head; \
@@ -1289,6 +2244,7 @@ void pop_back() \
     } \
   } \
  \
+CSFilterErase(node) \
   Free(node); \
   items--; \
   adjust_levels(); \
@@ -1296,6 +2252,7 @@ void pop_back() \
  \
 void destroy_back() \
 { \
+CSLAZY(compact();,) \
   if (items==0) return; \
  \
   node_type *cursor = head; \
@@ -1324,6 +2281,7 @@ void destroy_back() \
   } \
  \
   delete value(node->object); \
+CSFilterErase(node) \
   Free(node); \
   items--; \
   adjust_levels(); \
@@ -1387,18 +2345,32 @@ for(InIt i=first;i!=last;++i) op(*i)
   size_type ct = (count); \
   for(size_type i=0;i<ct;i++) op(val);
 
+#define CSNewUpdate(xMaxLevel) \
+new std::pair<size_type,node_type*>[(xMaxLevel)+1]
+
+// Containers built with CSSTATIC have maxLevel and probability as compile
+// time constants, an update array inside the object and head and tail built
+// in place in headStorage and tailStorage.  maxLevel is clamped to 255
+// because ForwardNode and BidiNode keep their room in a byte (BidiNode its
+// level too) and AdaptiveBidiNode its base.
 #define CSInitCore(xProbability, xMaxLevel) \
 CSINDEX(scan_index = -1,); \
-  this->probability = xProbability; \
-  this->maxLevel = xMaxLevel; \
-  update = new std::pair<size_type,node_type*>[xMaxLevel+1]; \
+CSSTATIC((void)(xProbability); \
+  (void)(xMaxLevel);,this->probability = level_generator::probability(xProbability); \
+  this->maxLevel = ((xMaxLevel)<255) ? (xMaxLevel) : 255; \
+  update = CSNewUpdate(this->maxLevel);) \
   level = 0; \
   items = 0; \
+CSFILTER(bloom = NULL;,) \
+CSLAZY(lazy = false; \
+  tombstones = 0;,) \
  \
-  head = Alloc(xMaxLevel); \
-  tail = Alloc(xMaxLevel); \
+CSSTATIC(head = new(&headStorage) node_type(this->maxLevel); \
+  tail = new(&tailStorage) node_type(this->maxLevel);, \
+  head = Alloc(this->maxLevel); \
+  tail = Alloc(this->maxLevel);) \
  \
-  for (unsigned int i=0; i<=xMaxLevel; i++) \
+  for (unsigned int i=0; i<=this->maxLevel; i++) \
   { \
 CSINDEX(head->skip(i) = 1; \
         tail->skip(i) = 0;,) \
@@ -1418,34 +2390,30 @@ void Init(double xProbability,size_type xMaxLevel) \
 }
 
 #define CSSwapCore \
+CSSTATIC(SwapSentinels(right);, \
   std::swap(maxLevel,right.maxLevel); \
-  std::swap(level,right.level); \
   std::swap(head,right.head); \
   std::swap(tail,right.tail); \
   std::swap(probability,right.probability); \
+  std::swap(update,right.update);) \
+  std::swap(level,right.level); \
   std::swap(items,right.items); \
-  std::swap(update,right.update); \
+CSFILTER(std::swap(bloom,right.bloom);,) \
+CSLAZY(std::swap(lazy,right.lazy); \
+  std::swap(tombstones,right.tombstones); \
+  graveyard.swap(right.graveyard);,) \
 CSINDEX(std::swap(scan_index, right.scan_index);,)
 
-#define CSDefineOperatorEqual \
-container_type& operator=(const container_type &source) \
-{ \
-  if (this==&source) return *this; \
-  clear(); \
- \
-CSINDEX(scan_index = -1,); \
-  probability = source.probability; \
-  level = CSLEVEL(source.level,1); \
-  items = source.items; \
- \
-  if (maxLevel<source.maxLevel) \
+// Regrows head, tail and update when xMaxLevel is higher than maxLevel.
+#define CSGrowCore(xMaxLevel) \
+  if (maxLevel<xMaxLevel) \
   { \
-    maxLevel = source.maxLevel; \
+    maxLevel = xMaxLevel; \
     delete[] update; \
     Free(head); \
     Free(tail); \
  \
-    update = new std::pair<size_type,node_type*>[maxLevel+1]; \
+    update = CSNewUpdate(maxLevel); \
  \
     head = Alloc(maxLevel); \
     tail = Alloc(maxLevel); \
@@ -1455,7 +2423,57 @@ CSINDEX(scan_index = -1,); \
 CSBIDI(head->backward(i) = NULL;,) \
 CSINDEX(tail->skip(i) = 0;,) \
     } \
+  }
+
+// Swaps the contents of two containers whose head and tail live inside the
+// container object: the sentinels' pointers are exchanged and the first and
+// last node of every level in use are pointed at their new sentinels.
+// clear() leaves the head's links above level dangling, so those levels
+// are reset to head and tail instead of followed.  Called before level
+// itself is swapped.
+#define CSDefineSwapSentinels \
+void SwapSentinels(container_type &right) \
+{ \
+  for(unsigned int i=0;i<=maxLevel;i++) \
+  { \
+    std::swap(head->pointers[i], right.head->pointers[i]); \
+    std::swap(tail->pointers[i], right.tail->pointers[i]); \
+  } \
+  std::swap(head->level, right.head->level); \
+  std::swap(tail->level, right.tail->level); \
+  RelinkSentinels(right, right.level); \
+  right.RelinkSentinels(*this, level); \
+} \
+ \
+void RelinkSentinels(const container_type &other, size_type top) \
+{ \
+  for(unsigned int i=0;i<=maxLevel;i++) \
+  { \
+    if ((i>top)||(head->forward(i)==other.tail)) \
+    { \
+      head->forward(i) = tail; \
+      tail->backward(i) = head; \
+    } \
+    else \
+    { \
+      head->forward(i)->backward(i) = head; \
+      tail->backward(i)->forward(i) = tail; \
+    } \
   } \
+}
+
+#define CSDefineOperatorEqual \
+container_type& operator=(const container_type &source) \
+{ \
+  if (this==&source) return *this; \
+  clear(); \
+ \
+CSINDEX(scan_index = -1,); \
+CSSTATIC(,probability = source.probability;) \
+  level = CSLEVEL(source.level,1); \
+  items = source.size(); \
+ \
+CSSTATIC(,CSGrowCore(source.maxLevel)) \
  \
 CSLEVEL(head->level = level;,) \
 CSLEVEL(tail->level = level;,) \
@@ -1486,6 +2504,7 @@ CSBIDI(tail->backward(k) = head;,) \
     } \
 ) \
     node_type *item = Alloc(itemLevel,*i); \
+CSFILTER(if (bloom!=NULL) bloom->insert(key(*i));,) \
     unsigned int j = 0; \
     for(;j<=itemLevel;j++) \
     { \
@@ -1549,6 +2568,7 @@ CSUNIQUE(slpair,iterator) insert(const value_type& val) \
  \
 CSUNIQUE(if ((update[0].second->forward(0)!=tail)&&(!ValueComp(val,update[0].second->forward(0)->object))),) \
 CSUNIQUE({,) \
+CSUNIQUE(CSLAZY(  if (update[0].second->forward(0)->state&node_dead) return slpair(iterator(this,Revive(update[0].second->forward(0),val)),true);,),) \
 CSUNIQUE(  return slpair(CSINDEX(iterator(this,update[0].second->forward(0),scan_index),iterator(this,update[0].second->forward(0))),false),); \
 CSUNIQUE(},) \
  \
@@ -1583,6 +2603,7 @@ CSINDEX(for(;i<=level;i++) \
   { \
     update[i].second->skip(i)++; \
   },) \
+CSFILTER(if (bloom!=NULL) bloom->insert(key(val));,) \
   items++; \
   return CSUNIQUE(slpair(CSINDEX(iterator(this,cursor,scan_index),iterator(this,cursor)),true),CSINDEX(iterator(this,cursor,scan_index),iterator(this,cursor))); \
 }
@@ -1619,6 +2640,25 @@ CSINDEX(update[i].first = pos,); \
 CSINDEX(scan_index = update[0].first+1,); \
 }
 
+// Fills update[0..top] for nodex from backward pointers instead of searching
+// from head.  Up to nodex's own level they are its backward pointers.  Above
+// that, each level starts from the one below and steps back through taller
+// nodes.  No keys are compared, and erase() only needs levels up to the
+// node's own, which costs O(node level).  Needs BidiNode and a head whose
+// level is kept up to date.  Not for indexed containers.
+#define CSDefineScanBack \
+void scan_back(const node_type *nodex, unsigned int top) const \
+{ \
+  unsigned int i = 0; \
+  for(;(i<=top)&&(i<=nodex->level);i++) update[i].second = nodex->backward(i); \
+  for(;i<=top;i++) \
+  { \
+    node_type *node = update[i-1].second; \
+    while ((node!=head)&&(node->level<i)) node = node->backward(node->level); \
+    update[i].second = node; \
+  } \
+}
+
 // Working on this.
 // Must be Bidi, have level.
 // TODO: Check if scan_index is valid.  Also check if next node is valid for non-indexed containers.
@@ -1760,23 +2800,34 @@ void scan(size_type index) const \
 #define CSDefineScanIterator \
 void scan(const iterator &where) const \
 { \
-CSINDEX(scan(where.Findex),scan(where.node)); \
+CSINDEX(scan(where.Findex),CSBIDI(scan_back(where.node, (unsigned int)level),scan(where.node))); \
 }
 
 #define CSDefineErase \
 iterator erase(const iterator &where) \
 { \
   if CSINDEX((where.Findex>=items),((where.node==tail)||(where.node==head))) return end(); \
+CSLAZY(if (lazy) \
+  { \
+    Kill(where.node); \
+    return iterator(this,Live(where.node->forward(0))); \
+  },) \
  \
-CSINDEX(if (scan_index!=where.Findex) scan(where.Findex),scan(where));  \
+CSINDEX(if (scan_index!=where.Findex) scan(where.Findex); \
   if ((update[0].second==tail)||(update[0].second->forward(0)==tail)) return end();  /* Error */ \
  \
   node_type *cursor = update[0].second->forward(0); \
  \
- if (cursor!=where.node) return end(); \
+  if (cursor!=where.node) return end();, \
+  node_type *cursor = where.node; \
+  /* Only the levels the node is on get relinked. */ \
+CSBIDI(scan_back(cursor, cursor->level), \
+  scan(where); \
+  if (update[0].second->forward(0)!=cursor) return end()); \
+) \
  \
   unsigned int i=0; \
-  for (; (i<=level)&&(update[i].second->forward(i) == cursor); i++) \
+  for (; (i<=CSINDEX(level,cursor->level))&&(update[i].second->forward(i) == cursor); i++) \
   { \
 CSINDEX(update[i].second->skip(i) += cursor->skip(i)-1,); \
     update[i].second->forward(i) = cursor->forward(i); \
@@ -1788,6 +2839,7 @@ CSINDEX(for(;i<=level;i++) \
   },) \
  \
   node_type *cursor2 = cursor->forward(0); \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -1856,6 +2908,8 @@ void erase(node_type *node) \
 void cut(const iterator &first, const iterator &last, container_type& right) \
 { \
   if (first==last) return; \
+CSLAZY(compact(); \
+  right.compact();,) \
  \
   if (level>right.maxLevel) \
     throw level_exception(); \
@@ -1896,12 +2950,14 @@ CSINDEX(total=tmp_total,); \
 CSINDEX(,node1 = node1->forward(i)); \
     } \
  \
-CSINDEX(,node1 = cursor->forward(0); \
+    /* Equal keys stop the walk above short of last, so multi containers */ \
+    /* finish it on level 0.  Unique keys need no such walk. */ \
+CSINDEX(,CSUNIQUE(,node1 = cursor->forward(0); \
     while(node1!=last.node) \
     { \
       if (node1->level>=i) cursor = node1; \
       node1 = node1->forward(0); \
-    }) \
+    })) \
  \
     /* Create the link */ \
     if (update[i].second==cursor) \
@@ -1934,6 +2990,15 @@ CSINDEX(, \
   right.items = diff; \
   ) \
  \
+CSFILTER(if ((bloom!=NULL)||(right.bloom!=NULL)) \
+  { \
+    for(cursor=right.head->forward(0);cursor!=right.tail;cursor=cursor->forward(0)) \
+    { \
+      if (bloom!=NULL) bloom->erase(key(cursor->object)); \
+      if (right.bloom!=NULL) right.bloom->insert(key(cursor->object)); \
+    } \
+  },) \
+ \
   right.adjust_levels(); \
  \
   items-=diff; \
@@ -2001,8 +3066,13 @@ CSBIDI(tmp.tail->backward(0) = tmp.head,); \
 iterator erase(const iterator &first, const iterator &last) \
 { \
   if (first==last) return last; \
+CSLAZY(if (lazy) \
+  { \
+    for(iterator i=first;i!=last;++i) Kill(i.node); \
+    return last; \
+  },) \
  \
-  container_type tmp(probability,maxLevel); \
+CSSTATIC(container_type tmp;,container_type tmp(probability,maxLevel);) \
  \
 CSINDEX(cut(first,last,tmp); \
  \
@@ -2022,7 +3092,7 @@ iterator destroy(const iterator &first, const iterator &last) \
 { \
   if (first==last) return last; \
  \
-  container_type tmp(probability,maxLevel); \
+CSSTATIC(container_type tmp;,container_type tmp(probability,maxLevel);) \
  \
 CSINDEX(cut(first,last,tmp); \
  \
@@ -2047,9 +3117,16 @@ size_type erase(const key_type &keyval) \
  \
   node_type *cursor = update[0].second->forward(0); \
  \
-  if ((key_comp()(keyval,key(cursor->object)))|| \
-      (key_comp()(key(cursor->object),keyval))) \
+  /* scan_key() stopped before the first key not below keyval, so one */ \
+  /* comparison settles equality. */ \
+  if (key_comp()(keyval,key(cursor->object))) \
     return 0; \
+CSLAZY(if (lazy) \
+  { \
+    if (cursor->state&node_dead) return 0; \
+    Kill(cursor); \
+    return 1; \
+  },) \
  \
   size_type cnt = 0; \
   do \
@@ -2066,12 +3143,12 @@ CSINDEX(for(;i<=level;i++) \
       update[i].second->skip(i)--; \
     },) \
     node_type *cursor3 = cursor->forward(0); \
+CSFilterErase(cursor) \
     Free(cursor); \
     cursor = cursor3; \
     items--; \
     cnt++; \
-  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))&& \
-      (!key_comp()(key(cursor->object),keyval))); \
+  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))); \
  \
   adjust_levels(); \
  \
@@ -2080,14 +3157,16 @@ CSINDEX(for(;i<=level;i++) \
  \
 size_type destroy(const key_type &keyval) \
 { \
+CSLAZY(compact();,) \
   scan_key(keyval); \
  \
   if ((update[0].second==tail)||(update[0].second->forward(0)==tail)) return 0;  /* Error */ \
  \
   node_type *cursor = update[0].second->forward(0); \
  \
-  if ((key_comp()(keyval,key(cursor->object)))|| \
-      (key_comp()(key(cursor->object),keyval))) \
+  /* scan_key() stopped before the first key not below keyval, so one */ \
+  /* comparison settles equality. */ \
+  if (key_comp()(keyval,key(cursor->object))) \
     return 0; \
  \
   size_type cnt = 0; \
@@ -2106,12 +3185,12 @@ CSINDEX(for(;i<=level;i++) \
     },) \
     node_type *cursor3 = cursor->forward(0); \
     delete value(cursor->object); \
+CSFilterErase(cursor) \
     Free(cursor); \
     cursor = cursor3; \
     items--; \
     cnt++; \
-  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))&& \
-      (!key_comp()(key(cursor->object),keyval))); \
+  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))); \
  \
   adjust_levels(); \
  \
@@ -2126,12 +3205,20 @@ size_type erase(const key_type &keyval, iterator &next) \
  \
   node_type *cursor = update[0].second->forward(0); \
  \
-  if ((key_comp()(keyval,key(cursor->object)))|| \
-      (key_comp()(key(cursor->object),keyval))) \
+  /* scan_key() stopped before the first key not below keyval, so one */ \
+  /* comparison settles equality. */ \
+  if (key_comp()(keyval,key(cursor->object))) \
   { \
     next = end(); \
     return 0; \
   } \
+CSLAZY(if (lazy) \
+  { \
+    if (cursor->state&node_dead) { next = end(); return 0; } \
+    Kill(cursor); \
+    next = iterator(this,Live(cursor->forward(0))); \
+    return 1; \
+  },) \
  \
   size_type cnt = 0; \
   do \
@@ -2148,12 +3235,12 @@ CSINDEX(for(;i<=level;i++) \
       update[i].second->skip(i)--; \
     },) \
     node_type *cursor3 = cursor->forward(0); \
+CSFilterErase(cursor) \
     Free(cursor); \
     cursor = cursor3; \
     items--; \
     cnt++; \
-  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))&& \
-      (!key_comp()(key(cursor->object),keyval))); \
+  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))); \
  \
   adjust_levels(); \
  \
@@ -2163,14 +3250,16 @@ CSINDEX(for(;i<=level;i++) \
  \
 size_type destroy(const key_type &keyval, iterator &next) \
 { \
+CSLAZY(compact();,) \
   scan_key(keyval); \
  \
   if ((update[0].second==tail)||(update[0].second->forward(0)==tail)) { next = end(); return 0;}  /* Error */ \
  \
   node_type *cursor = update[0].second->forward(0); \
  \
-  if ((key_comp()(keyval,key(cursor->object)))|| \
-      (key_comp()(key(cursor->object),keyval))) \
+  /* scan_key() stopped before the first key not below keyval, so one */ \
+  /* comparison settles equality. */ \
+  if (key_comp()(keyval,key(cursor->object))) \
   { \
     next = end(); \
     return 0; \
@@ -2192,12 +3281,12 @@ CSINDEX(for(;i<=level;i++) \
     },) \
     node_type *cursor3 = cursor->forward(0); \
     delete value(cursor->object); \
+CSFilterErase(cursor) \
     Free(cursor); \
     cursor = cursor3; \
     items--; \
     cnt++; \
-  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))&& \
-      (!key_comp()(key(cursor->object),keyval))); \
+  } while ((cursor!=tail)&&(!key_comp()(keyval,key(cursor->object)))); \
  \
   adjust_levels(); \
  \
@@ -2229,6 +3318,7 @@ CSBIDI(cursor->forward(i)->backward(i) = cursor->backward(i),); \
   } \
  \
   node_type *cursor2 = cursor->forward(0); \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -2259,6 +3349,7 @@ CSBIDI(cursor->forward(i)->backward(i) = cursor->backward(i),); \
  \
   node_type *cursor2 = cursor->forward(0); \
   delete value(cursor->object); \
+CSFilterErase(cursor) \
   Free(cursor); \
   items--; \
   adjust_levels(); \
@@ -0,0 +1,346 @@
+/*
+   Description: Header file for SmallKeyedSkipList
+                Map that keeps up to N entries in a sorted array inside the
+                object and turns into a KeyedSkipList when it overflows.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSSmallSkipListH
+#define CSSmallSkipListH
+
+#include <utility>
+#include <iterator>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include "CSKeyedSkipList.h"
+
+namespace CS
+{
+
+// Iterator over either representation of a SmallKeyedSkipList.  item points
+// into the inline array while the container is small and is NULL once it is
+// large, in which case big is used.
+template<class V, class BigIt>
+class SmallIterator : public std::iterator<std::bidirectional_iterator_tag, typename std::remove_const<V>::type, ptrdiff_t, V*, V&>
+{
+public:
+// WARNING:  DO NOT WRITE TO THE FOLLOWING MEMBERS!!!
+  V *item;
+  BigIt big;
+
+  SmallIterator() : item(NULL) {}
+  explicit SmallIterator(V *item) : item(item) {}
+  explicit SmallIterator(const BigIt &big) : item(NULL), big(big) {}
+  template<class V2, class BigIt2> SmallIterator(const SmallIterator<V2,BigIt2> &right) : item(right.item), big(right.big) {}
+
+  V& operator*() const { return (item!=NULL) ? *item : *big; }
+  V* operator->() const { return &**this; }
+
+  SmallIterator& operator++()
+  {
+    if (item!=NULL) ++item; else ++big;
+    return *this;
+  }
+
+  SmallIterator operator++(int)
+  {
+    SmallIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  SmallIterator& operator--()
+  {
+    if (item!=NULL) --item; else --big;
+    return *this;
+  }
+
+  SmallIterator operator--(int)
+  {
+    SmallIterator old = *this;
+    --*this;
+    return old;
+  }
+
+  template<class V2, class BigIt2> bool operator==(const SmallIterator<V2,BigIt2> &right) const
+  {
+    return (item==right.item)&&((item!=NULL)||(big==right.big));
+  }
+
+  template<class V2, class BigIt2> bool operator!=(const SmallIterator<V2,BigIt2> &right) const
+  {
+    return !(*this==right);
+  }
+};
+
+// Map for the many containers that hold only a handful of entries.  Up to N
+// entries sit sorted in an array inside the object and are found by a linear
+// scan, so an empty container allocates nothing.  The insert that would make
+// it N+1 entries moves everything into a KeyedSkipList, which is used from
+// then on.  clear() goes back to the array.
+template <class K, class T, class Pr, class R, class A, unsigned int N = 8>
+class SmallKeyedSkipList
+{
+public:
+  typedef SmallKeyedSkipList<K,T,Pr,R,A,N> container_type;
+  typedef KeyedSkipList<K,T,Pr,R,A> large_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T& const_mapped_type_reference;
+  typedef SmallIterator<value_type, typename large_type::iterator> iterator;
+  typedef SmallIterator<const value_type, typename large_type::const_iterator> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef Pr key_compare;
+
+private:
+  typedef typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type slot_type;
+  typedef typename A::template rebind<large_type>::other large_allocator;
+
+  key_compare KeyCompare;
+  unsigned int items; //!< Entries in the array.  0 once large.
+  large_type *large; //!< The skiplist after the first overflow, NULL before.
+  slot_type slots[N];
+
+  value_type* Slots() { return reinterpret_cast<value_type*>(slots); }
+  const value_type* Slots() const { return reinterpret_cast<const value_type*>(slots); }
+
+  // First entry in the array whose key is not less than keyval.
+  size_type LowerSlot(const key_type &keyval) const
+  {
+    size_type i = 0;
+    while ((i<items)&&(KeyCompare(Slots()[i].first,keyval))) i++;
+    return i;
+  }
+
+  void MoveSlot(size_type to, size_type from)
+  {
+    new(&Slots()[to]) value_type(std::move(Slots()[from]));
+    Slots()[from].~value_type();
+  }
+
+  // Moves the array into a new skiplist.
+  void Grow()
+  {
+    large_allocator alloc;
+    large_type *list = alloc.allocate(1);
+    try
+    {
+      alloc.construct(list, KeyCompare);
+      try
+      {
+        for(size_type i=0;i<items;i++) list->insert(Slots()[i]);
+      }
+      catch(...)
+      {
+        alloc.destroy(list);
+        throw;
+      }
+    }
+    catch(...)
+    {
+      alloc.deallocate(list, 1);
+      throw;
+    }
+    for(size_type i=0;i<items;i++) Slots()[i].~value_type();
+    items = 0;
+    large = list;
+  }
+
+  template<class InIt> void CopyFrom(InIt first, InIt last)
+  {
+    for(InIt i=first;i!=last;++i) insert(*i);
+  }
+
+public:
+  SmallKeyedSkipList() : KeyCompare(Pr()), items(0), large(NULL) {}
+  explicit SmallKeyedSkipList(const key_compare& comp) : KeyCompare(comp), items(0), large(NULL) {}
+  SmallKeyedSkipList(const container_type &source) : KeyCompare(source.KeyCompare), items(0), large(NULL) { CopyFrom(source.begin(), source.end()); }
+  template<class InIt> SmallKeyedSkipList(InIt first, InIt last) : KeyCompare(Pr()), items(0), large(NULL) { CopyFrom(first, last); }
+  ~SmallKeyedSkipList() { clear(); }
+
+  container_type& operator=(const container_type &source)
+  {
+    if (this==&source) return *this;
+    clear();
+    KeyCompare = source.KeyCompare;
+    CopyFrom(source.begin(), source.end());
+    return *this;
+  }
+
+  bool is_large() const { return large!=NULL; }
+
+  iterator begin() { return (large!=NULL) ? iterator(large->begin()) : iterator(Slots()); }
+  iterator end() { return (large!=NULL) ? iterator(large->end()) : iterator(Slots()+items); }
+  const_iterator begin() const { return (large!=NULL) ? const_iterator(static_cast<const large_type*>(large)->begin()) : const_iterator(Slots()); }
+  const_iterator end() const { return (large!=NULL) ? const_iterator(static_cast<const large_type*>(large)->end()) : const_iterator(Slots()+items); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  size_type size() const { return (large!=NULL) ? large->size() : items; }
+  bool empty() const { return size()==0; }
+  size_type max_size() const { return large_type().max_size(); }
+
+  slpair insert(const value_type &val)
+  {
+    if (large!=NULL)
+    {
+      typename large_type::slpair result = large->insert(val);
+      return slpair(iterator(result.first), result.second);
+    }
+
+    size_type pos = LowerSlot(val.first);
+    if ((pos<items)&&(!KeyCompare(val.first,Slots()[pos].first))) return slpair(iterator(Slots()+pos), false);
+    if (items==N)
+    {
+      Grow();
+      return insert(val);
+    }
+
+    /* Construct the new entry first, so a throwing copy leaves the array as it was. */
+    value_type item(val);
+    for(size_type i=items;i>pos;i--) MoveSlot(i, i-1);
+    new(&Slots()[pos]) value_type(std::move(item));
+    items++;
+    return slpair(iterator(Slots()+pos), true);
+  }
+
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; }
+  template<class InIt> void insert(InIt first, InIt last) { CopyFrom(first, last); }
+
+  iterator erase(const iterator &where)
+  {
+    if (large!=NULL) return iterator(large->erase(where.big));
+    size_type pos = where.item-Slots();
+    if (pos>=items) return end();
+    Slots()[pos].~value_type();
+    for(size_type i=pos+1;i<items;i++) MoveSlot(i-1, i);
+    items--;
+    return iterator(Slots()+pos);
+  }
+
+  size_type erase(const key_type &keyval)
+  {
+    if (large!=NULL) return large->erase(keyval);
+    iterator where = find(keyval);
+    if (where==end()) return 0;
+    erase(where);
+    return 1;
+  }
+
+  void clear()
+  {
+    if (large!=NULL)
+    {
+      large_allocator alloc;
+      alloc.destroy(large);
+      alloc.deallocate(large, 1);
+      large = NULL;
+    }
+    for(size_type i=0;i<items;i++) Slots()[i].~value_type();
+    items = 0;
+  }
+
+  void swap(container_type &right)
+  {
+    if ((large!=NULL)&&(right.large!=NULL))
+    {
+      std::swap(large, right.large);
+      std::swap(KeyCompare, right.KeyCompare);
+      return;
+    }
+    container_type temp(right);
+    right = *this;
+    *this = temp;
+  }
+
+  mapped_type_reference operator[](const key_type& key)
+  {
+    return insert(value_type(key, mapped_type())).first->second;
+  }
+
+  key_compare key_comp() const { return KeyCompare; }
+
+  iterator find(const key_type &keyval)
+  {
+    if (large!=NULL) return iterator(large->find(keyval));
+    size_type pos = LowerSlot(keyval);
+    if ((pos==items)||(KeyCompare(keyval,Slots()[pos].first))) return end();
+    return iterator(Slots()+pos);
+  }
+
+  const_iterator find(const key_type &keyval) const
+  {
+    if (large!=NULL) return const_iterator(static_cast<const large_type*>(large)->find(keyval));
+    size_type pos = LowerSlot(keyval);
+    if ((pos==items)||(KeyCompare(keyval,Slots()[pos].first))) return end();
+    return const_iterator(Slots()+pos);
+  }
+
+  size_type count(const key_type &keyval) const { return (find(keyval)==end()) ? 0 : 1; }
+
+  iterator lower_bound(const key_type &keyval)
+  {
+    if (large!=NULL) return iterator(large->lower_bound(keyval));
+    return iterator(Slots()+LowerSlot(keyval));
+  }
+
+  const_iterator lower_bound(const key_type &keyval) const
+  {
+    if (large!=NULL) return const_iterator(static_cast<const large_type*>(large)->lower_bound(keyval));
+    return const_iterator(Slots()+LowerSlot(keyval));
+  }
+
+  iterator upper_bound(const key_type &keyval)
+  {
+    iterator i = lower_bound(keyval);
+    if ((i!=end())&&(!KeyCompare(keyval,i->first))) ++i;
+    return i;
+  }
+
+  const_iterator upper_bound(const key_type &keyval) const
+  {
+    const_iterator i = lower_bound(keyval);
+    if ((i!=end())&&(!KeyCompare(keyval,i->first))) ++i;
+    return i;
+  }
+};
+
+template <class K, class T, class Pr, class R, class A, unsigned int N>
+bool operator==(const SmallKeyedSkipList<K,T,Pr,R,A,N> &left, const SmallKeyedSkipList<K,T,Pr,R,A,N> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+}
+
+template <class K, class T, class Pr, class R, class A, unsigned int N>
+bool operator!=(const SmallKeyedSkipList<K,T,Pr,R,A,N> &left, const SmallKeyedSkipList<K,T,Pr,R,A,N> &right)
+{
+  return !(left==right);
+}
+
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+   Description: Header file for StaticKeyedSkipList
+                KeyedSkipList with its maximum level and probability fixed
+                at compile time.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef CSStaticSkipListH
+#define CSStaticSkipListH
+
+#include <array>
+#include <utility>
+#include <iterator>
+#include <functional>
+#include <ratio>
+#include <type_traits>
+#include "CSSkipListTools.h"
+#include "CSIterators.h"
+
+namespace CS
+{
+#define CSBIDI(a,b) a
+#define CSUNIQUE(a,b) a
+#define CSINDEX(a,b) b
+#define CSKEY(a,b) a
+#define CSLEVEL(a,b) a
+#define CSFILTER(a,b) b
+#define CSLAZY(a,b) b
+#define CSSTATIC(a,b) a
+#define CSADAPT(a,b) b
+
+// Like KeyedSkipList, but MaxLevel and the probability P (a std::ratio) are
+// template parameters.  The update array and the head and tail sentinels
+// live inside the object, so creating a list allocates nothing, and the
+// loops over every level (init, swap, stats) have constant bounds.
+// Searches still start at the highest level in use, as in KeyedSkipList;
+// starting at MaxLevel would give them a constant bound too, but costs a
+// step per empty level on every search.  The defaults match the levels of
+// a default constructed KeyedSkipList.  There is no membership filter and
+// no lazy deletion.
+template <class K, class T, class Pr, class R, class A, unsigned int MaxLevel = 8, class P = std::ratio<1,4> >
+class StaticKeyedSkipList
+{
+public:
+  typedef CSUNIQUE(CSKEY(uniquekey_tag,unique_tag),CSKEY(multikey_tag,multi_tag)) tag;
+  typedef StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P> container_type;
+  typedef BidiIterator<container_type> T0;
+  typedef ConstBidiIterator<container_type> T1;
+  friend class BidiIterator<container_type>;
+  friend class ConstBidiIterator<container_type>;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef K key_type;
+  typedef std::pair<const K, T> value_type;
+  typedef BidiNode<value_type> node_type;
+  typedef T0 iterator;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+  typedef T data_type;
+  typedef T mapped_type;
+  typedef T& mapped_type_reference;
+  typedef const T const_mapped_type;
+  typedef const T& const_mapped_type_reference;
+  typedef const value_type& const_reference;
+  typedef T1 const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef std::pair<iterator, bool> slpair;
+  typedef std::pair<iterator, iterator> ipair;
+  typedef std::pair<const_iterator, const_iterator> const_ipair;
+  typedef Pr key_compare;
+  typedef KeyOrder<Pr, K> key_order;
+  typedef GeometricLevels level_generator;
+
+  class value_compare
+    : public std::binary_function<value_type, value_type, bool>
+  {
+  friend class StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P>;
+  public:
+    bool operator()(const value_type& left, const value_type& right) const
+      {return (comp(left.first, right.first)); }
+  protected:
+    value_compare(const key_compare &pr) : comp(pr) {}
+    key_compare comp;
+  };
+
+private:
+  R rng;
+  key_compare KeyCompare;
+  value_compare ValueCompare;
+  typedef typename std::aligned_storage<sizeof(node_type)+MaxLevel*sizeof(typename node_type::ptr_type), alignof(node_type)>::type sentinel_storage;
+  static const size_type maxLevel = MaxLevel; //!< Maximum number of forward pointers possible.
+  static_assert(MaxLevel<=255, "nodes keep their level in a byte");
+  size_type level;    //!< The maximum number of forward pointers on any given container currently in use.
+  node_type *head,*tail; //!< Start and end containers.  Point into headStorage and tailStorage.
+  sentinel_storage headStorage, tailStorage;
+  static constexpr double probability = (double)P::num/(double)P::den; //!< Probability to go to the next level.
+  size_type items; //!< Number of items in the list.
+  mutable std::array<std::pair<size_type,node_type*>, MaxLevel+1> update;
+  CSDefineInit
+  node_type* Alloc(size_type level, const value_type &obj) CSAlloc2(A, level,obj,node_type)
+  node_type* Alloc(size_type level) CSAlloc(A, level,node_type)
+  void Free(node_type *item) CSFree(A, item,node_type)
+  CSDefineGenerateRandomLevel
+  CSDefineAdjustLevels
+  CSDefineScanKey
+  CSDefineScanVal
+  CSDefineScanIterator
+  CSDefineScanNode
+  CSDefineScanBack
+  CSDefineSwapSentinels
+public:
+
+  CheckSkipNodes
+  CSDefineStats
+
+  StaticKeyedSkipList() : ValueCompare(Pr()) { CSInitPM; }
+  StaticKeyedSkipList(const container_type &source) : ValueCompare(source.ValueCompare), KeyCompare(source.KeyCompare) { CSInitPM; CSCopyITIT(const_iterator, source.begin(),source.end(),insert); }
+  template<class InIt> StaticKeyedSkipList(InIt first, InIt last) : ValueCompare(Pr()) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
+  explicit StaticKeyedSkipList(const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitPM; }
+  template<class InIt> StaticKeyedSkipList(InIt first, InIt last, const key_compare& comp) : ValueCompare(comp), KeyCompare(comp) { CSInitPM; CSCopyITIT(InIt, first,last,insert); }
+  ~StaticKeyedSkipList() { clear(); head->~node_type(); tail->~node_type(); }
+  CSDefineOperatorEqual
+
+  CSDefineBeginEnd
+  CSDefineRBeginEnd
+  CSDefineSize
+  CSDefineEmpty
+  CSDefineFront
+  CSDefineBackBidi
+  CSDefinePopFront
+  CSDefinePopBackBidi
+  CSDefineAssignITIT(insert)
+
+  CSDefineInsertVal
+  iterator insert(const iterator &where, const value_type& val) { return insert(val).first; } // Don't use this.  Calls insert(const value_type& type);
+  template<class InIt> void insert(InIt first, InIt last) { CSCopyITIT(InIt, first, last, insert); }
+
+  CSDefineErase
+  CSDefineEraseITIT
+  CSDefineEraseKey
+
+  CSDefineClear
+  CSDefineDestroy
+  void swap(container_type& right) { CSSwapCore std::swap(ValueCompare, right.ValueCompare); std::swap(KeyCompare, right.KeyCompare); }
+  CSDefineEraseIf
+  CSDefineDestroyIf
+
+  CSDefineCut
+  CSDefineSplit
+  CSDefineAssignSorted
+  CSDefineOperatorArrayMap
+  CSDefineOperatorArrayMap2
+
+  CSDefineKeyCompare(KeyCompare)
+  CSDefineValueCompare(ValueCompare)
+  CSDefineMaxSize
+
+  const key_type& key(const_reference value) const {return value.first;}
+  mapped_type_reference value(reference value) const {return value.second;}
+  const_mapped_type_reference value(const_reference value) const {return value.second;}
+  CSDefineFind
+  CSDefineFindSteps
+  CSDefineCount
+  CSDefineLowerBound
+  CSDefineUpperBound
+  CSDefineEqualRange
+};
+
+template <class K, class T, class Pr, class R, class A, unsigned int MaxLevel, class P>
+const typename StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P>::size_type StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P>::maxLevel;
+
+template <class K, class T, class Pr, class R, class A, unsigned int MaxLevel, class P>
+constexpr double StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P>::probability;
+
+template <class K, class T, class Pr, class R, class A, unsigned int MaxLevel, class P>
+bool operator==(const StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P> &left, const StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P> &right)
+{
+  return ((left.size() == right.size()) &&
+          (std::equal(left.begin(), left.end(), right.begin())));
+
+}
+
+template <class K, class T, class Pr, class R, class A, unsigned int MaxLevel, class P>
+bool operator<(const StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P> &left, const StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P> &right)
+{
+  return lexicographical_compare(left.begin(),left.end(),right.begin(),right.end(),left.value_comp());
+}
+
+#define csarg1 template<class K, class T, class Pr, class R, class A, unsigned int MaxLevel, class P>
+#define csarg2 StaticKeyedSkipList<K,T,Pr,R,A,MaxLevel,P>
+CSDefineCompOps(csarg1, csarg2)
+#undef csarg1
+#undef csarg2
+
+#undef CSFILTER
+#undef CSLAZY
+#undef CSADAPT
+#undef CSSTATIC
+#undef CSKEY
+#undef CSINDEX
+#undef CSUNIQUE
+#undef CSBIDI
+#undef CSLEVEL
+
+}
+
+
+#endif
+
@@ -1,7 +1,10 @@
 #include "load.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
+#include <random>
 
 std::vector<int> make_ints(int size) {
     std::vector<int> vec(size);
@@ -9,6 +12,21 @@ std::vector<int> make_ints(int size) {
     return vec;
 }
 
+std::vector<std::size_t> make_zipf_indices(std::size_t universe, std::size_t count, double skew) {
+    // Index i is drawn with probability proportional to 1/(i+1)^skew.
+    std::vector<double> cdf(universe);
+    double sum = 0;
+    for (std::size_t i = 0; i < universe; ++i)
+        cdf[i] = sum += 1 / std::pow(double(i + 1), skew);
+
+    std::mt19937 engine{std::random_device{}()};
+    std::uniform_real_distribution<double> dist(0, sum);
+    std::vector<std::size_t> vec(count);
+    for (auto& x : vec)
+        x = std::min<std::size_t>(std::lower_bound(cdf.begin(), cdf.end(), dist(engine)) - cdf.begin(), universe - 1);
+    return vec;
+}
+
 std::vector<std::string> read_lines(std::istream&& is) {
     std::vector<std::string> vec;
     std::string line;
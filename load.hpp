@@ -5,4 +5,5 @@
 #include <iosfwd>
 
 std::vector<int> make_ints(int size);
+std::vector<std::size_t> make_zipf_indices(std::size_t universe, std::size_t count, double skew);
 std::vector<std::string> read_lines(std::istream&& is);
@@ -3,6 +3,17 @@
 #include "print.hpp"
 
 #include "CSKeyedSkipList.h"
+#include "CSAdaptiveSkipList.h"
+#include "CSForwardSkipList.h"
+#include "CSCompactSkipList.h"
+#include "CSDeterministicSkipList.h"
+#include "CSHashedSkipList.h"
+#include "CSSkipListSet.h"
+#include "CSStaticSkipList.h"
+#include "CSSmallSkipList.h"
+#include "CSPagedSkipList.h"
+#include "sharded_map.hpp"
+#include "verdict_cache.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -54,6 +65,96 @@ struct Map<CS::KeyedSkipList, T> {
     using type = CS::KeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
 };
 
+template<typename T>
+struct Map<CS::AdaptiveKeyedSkipList, T> {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::AdaptiveKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+template<typename T>
+struct Map<CS::ForwardKeyedSkipList, T> {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::ForwardKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+template<typename T>
+struct Map<CS::CompactKeyedSkipList, T> {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::CompactKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+template<typename T>
+struct Map<CS::DeterministicKeyedSkipList, T> {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::DeterministicKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+template<typename T>
+struct Map<CS::HashedKeyedSkipList, T> {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::HashedKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+// A set has no mapped value, so its nodes hold the key alone.
+template<typename T>
+struct Map<CS::SkipListSet, T> {
+    using value_type = T;
+    template<template<typename> class Alloc>
+    using type = CS::SkipListSet<T, std::less<T>, Random, Alloc<value_type>>;
+};
+
+// StaticKeyedSkipList takes a non-type parameter, so it can't go through Map.
+template<typename T>
+struct StaticSkipListMap {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::StaticKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+// KeyedSkipList ordered by a given comparator, for COMPARE_REPORT.
+template<typename T>
+struct CompareSkipList {
+    using value_type = std::pair<const T, int>;
+    template<typename Compare>
+    using type = CS::KeyedSkipList<T, int, Compare, Random, std::allocator<value_type>>;
+};
+
+// KeyedSkipList drawing levels from the bits of one rand() call; the
+// default probability is 1/4, two bits per level.
+template<typename T>
+struct BitLevelSkipListMap {
+    using value_type = std::pair<const T, int>;
+    using policy = CS::SkipListPolicy<T, std::less<T>, CS::BitLevels<2>>;
+    template<template<typename> class Alloc>
+    using type = CS::KeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>, policy>;
+};
+
+template<typename T>
+struct SmallSkipListMap {
+    using value_type = std::pair<const T, int>;
+    template<template<typename> class Alloc>
+    using type = CS::SmallKeyedSkipList<T, int, std::less<T>, Random, Alloc<value_type>>;
+};
+
+// Spreads a map over 16 independently locked shards.
+template<template<typename...> class Underlying, typename T>
+struct ShardedMapOf {
+    template<template<typename> class Alloc>
+    using type = ShardedMap<typename Map<Underlying, T>::template type<Alloc>, 16>;
+};
+
+// Puts a per-thread verdict cache in front of a map.
+template<template<typename...> class Underlying, typename T>
+struct CachedMapOf {
+    template<template<typename> class Alloc>
+    using type = CachedMap<typename Map<Underlying, T>::template type<Alloc>>;
+};
+
 int main(int argc, char* argv[]) {
     std::cout.sync_with_stdio(false);
     std::cin.sync_with_stdio(false);
@@ -78,6 +179,20 @@ int main(int argc, char* argv[]) {
     print_aligned("Query");
     std::cout << ',';
     print_aligned("Memory");
+    std::cout << ',';
+    print_aligned("Levels");
+    std::cout << ',';
+    print_aligned("AvgPath");
+    std::cout << ',';
+    print_aligned("MaxPath");
+    std::cout << ',';
+    print_aligned("NodeBytes");
+    std::cout << ',';
+    print_aligned("PointerBytes");
+    std::cout << ',';
+    print_aligned("SentinelBytes");
+    std::cout << ',';
+    print_aligned("UpdateBytes");
     std::cout << std::endl;
 
     std::ostream_iterator<Result> output(std::cout, "\n");
@@ -86,6 +201,27 @@ int main(int argc, char* argv[]) {
     eval_structure<Map<CS::KeyedSkipList, int>::type>("skiplist", "ip", data_ips, output);
     eval_structure<Map<CS::KeyedSkipList, std::string>::type>("skiplist", "domain", data_domains, output);
     eval_structure<Map<CS::KeyedSkipList, std::string>::type>("skiplist", "full_path", data_fullpaths, output);
+    eval_structure<Map<CS::HashedKeyedSkipList, int>::type>("hashed_skiplist", "ip", data_ips, output);
+    eval_structure<Map<CS::HashedKeyedSkipList, std::string>::type>("hashed_skiplist", "domain", data_domains, output);
+    eval_structure<Map<CS::HashedKeyedSkipList, std::string>::type>("hashed_skiplist", "full_path", data_fullpaths, output);
+    eval_structure<Map<CS::SkipListSet, int>::type>("skiplist_set", "ip", data_ips, output);
+    eval_structure<Map<CS::SkipListSet, std::string>::type>("skiplist_set", "domain", data_domains, output);
+    eval_structure<Map<CS::SkipListSet, std::string>::type>("skiplist_set", "full_path", data_fullpaths, output);
+    eval_structure<BitLevelSkipListMap<int>::type>("bitlevel_skiplist", "ip", data_ips, output);
+    eval_structure<BitLevelSkipListMap<std::string>::type>("bitlevel_skiplist", "domain", data_domains, output);
+    eval_structure<BitLevelSkipListMap<std::string>::type>("bitlevel_skiplist", "full_path", data_fullpaths, output);
+    eval_structure<StaticSkipListMap<int>::type>("static_skiplist", "ip", data_ips, output);
+    eval_structure<StaticSkipListMap<std::string>::type>("static_skiplist", "domain", data_domains, output);
+    eval_structure<StaticSkipListMap<std::string>::type>("static_skiplist", "full_path", data_fullpaths, output);
+    eval_structure<Map<CS::ForwardKeyedSkipList, int>::type>("forward_skiplist", "ip", data_ips, output);
+    eval_structure<Map<CS::ForwardKeyedSkipList, std::string>::type>("forward_skiplist", "domain", data_domains, output);
+    eval_structure<Map<CS::ForwardKeyedSkipList, std::string>::type>("forward_skiplist", "full_path", data_fullpaths, output);
+    eval_structure<Map<CS::CompactKeyedSkipList, int>::type>("compact_skiplist", "ip", data_ips, output);
+    eval_structure<Map<CS::CompactKeyedSkipList, std::string>::type>("compact_skiplist", "domain", data_domains, output);
+    eval_structure<Map<CS::CompactKeyedSkipList, std::string>::type>("compact_skiplist", "full_path", data_fullpaths, output);
+    eval_structure<Map<CS::DeterministicKeyedSkipList, int>::type>("deterministic_skiplist", "ip", data_ips, output);
+    eval_structure<Map<CS::DeterministicKeyedSkipList, std::string>::type>("deterministic_skiplist", "domain", data_domains, output);
+    eval_structure<Map<CS::DeterministicKeyedSkipList, std::string>::type>("deterministic_skiplist", "full_path", data_fullpaths, output);
 #endif
 #ifndef NO_BST
     eval_structure<Map<std::map, int>::type>("bst", "ip", data_ips, output);
@@ -97,4 +233,337 @@ int main(int argc, char* argv[]) {
     eval_structure<Map<std::unordered_map, std::string>::type>("hashmap", "domain", data_domains, output);
     eval_structure<Map<std::unordered_map, std::string>::type>("hashmap", "full_path", data_fullpaths, output);
 #endif
+#ifndef NO_SHARDED
+    eval_structure<ShardedMapOf<CS::KeyedSkipList, int>::type>("sharded_skiplist", "ip", data_ips, output);
+    eval_structure<ShardedMapOf<CS::KeyedSkipList, std::string>::type>("sharded_skiplist", "domain", data_domains, output);
+    eval_structure<ShardedMapOf<CS::KeyedSkipList, std::string>::type>("sharded_skiplist", "full_path", data_fullpaths, output);
+    eval_structure<ShardedMapOf<std::map, int>::type>("sharded_bst", "ip", data_ips, output);
+    eval_structure<ShardedMapOf<std::map, std::string>::type>("sharded_bst", "domain", data_domains, output);
+    eval_structure<ShardedMapOf<std::map, std::string>::type>("sharded_bst", "full_path", data_fullpaths, output);
+    eval_structure<ShardedMapOf<std::unordered_map, int>::type>("sharded_hashmap", "ip", data_ips, output);
+    eval_structure<ShardedMapOf<std::unordered_map, std::string>::type>("sharded_hashmap", "domain", data_domains, output);
+    eval_structure<ShardedMapOf<std::unordered_map, std::string>::type>("sharded_hashmap", "full_path", data_fullpaths, output);
+#endif
+#ifdef FILTER_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("TargetFP");
+    std::cout << ',';
+    print_aligned("MeasuredFP");
+    std::cout << ',';
+    print_aligned("FilterMemory");
+    std::cout << ',';
+    print_aligned("MissQuery");
+    std::cout << ',';
+    print_aligned("FilteredMiss");
+    std::cout << std::endl;
+
+    std::ostream_iterator<FilterResult> filter_output(std::cout, "\n");
+    eval_filter<Map<CS::KeyedSkipList, int>::type>("ip", data_ips, filter_output);
+    eval_filter<Map<CS::KeyedSkipList, std::string>::type>("domain", data_domains, filter_output);
+    eval_filter<Map<CS::KeyedSkipList, std::string>::type>("full_path", data_fullpaths, filter_output);
+#endif
+#ifdef PARALLEL_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Threads");
+    std::cout << ',';
+    print_aligned("FullScan");
+    std::cout << std::endl;
+
+    std::ostream_iterator<ScanResult> scan_output(std::cout, "\n");
+    eval_parallel_scan<Map<CS::KeyedSkipList, int>::type>("ip", data_ips, scan_output);
+    eval_parallel_scan<Map<CS::KeyedSkipList, std::string>::type>("domain", data_domains, scan_output);
+    eval_parallel_scan<Map<CS::KeyedSkipList, std::string>::type>("full_path", data_fullpaths, scan_output);
+#endif
+#ifdef BUILD_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Threads");
+    std::cout << ',';
+    print_aligned("Insert");
+    std::cout << ',';
+    print_aligned("Build");
+    std::cout << std::endl;
+
+    std::ostream_iterator<BuildResult> build_output(std::cout, "\n");
+    eval_build<Map<CS::KeyedSkipList, int>::type>("ip", data_ips, build_output);
+    eval_build<Map<CS::KeyedSkipList, std::string>::type>("domain", data_domains, build_output);
+    eval_build<Map<CS::KeyedSkipList, std::string>::type>("full_path", data_fullpaths, build_output);
+#endif
+#ifdef LAZY_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Erase");
+    std::cout << ',';
+    print_aligned("LazyErase");
+    std::cout << ',';
+    print_aligned("Compact");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("TombstoneQuery");
+    std::cout << std::endl;
+
+    std::ostream_iterator<LazyResult> lazy_output(std::cout, "\n");
+    eval_lazy_erase<Map<CS::KeyedSkipList, int>::type>("ip", data_ips, lazy_output);
+    eval_lazy_erase<Map<CS::KeyedSkipList, std::string>::type>("domain", data_domains, lazy_output);
+    eval_lazy_erase<Map<CS::KeyedSkipList, std::string>::type>("full_path", data_fullpaths, lazy_output);
+#endif
+#ifdef TUNE_SKIPLIST
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Probability");
+    std::cout << ',';
+    print_aligned("MaxLevel");
+    std::cout << ',';
+    print_aligned("Insert");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("Memory");
+    std::cout << ',';
+    print_aligned("Pareto");
+    std::cout << std::endl;
+
+    std::ostream_iterator<TuneResult> tune_output(std::cout, "\n");
+    eval_tuning<Map<CS::KeyedSkipList, int>::type>("ip", data_ips, tune_output);
+    eval_tuning<Map<CS::KeyedSkipList, std::string>::type>("domain", data_domains, tune_output);
+    eval_tuning<Map<CS::KeyedSkipList, std::string>::type>("full_path", data_fullpaths, tune_output);
+#endif
+#ifdef ZIPF_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Skew");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("AdaptiveQuery");
+    std::cout << ',';
+    print_aligned("Adapt");
+    std::cout << std::endl;
+
+    std::ostream_iterator<ZipfResult> zipf_output(std::cout, "\n");
+    eval_zipf<Map<CS::KeyedSkipList, int>::type, Map<CS::AdaptiveKeyedSkipList, int>::type>("ip", data_ips, zipf_output);
+    eval_zipf<Map<CS::KeyedSkipList, std::string>::type, Map<CS::AdaptiveKeyedSkipList, std::string>::type>("domain", data_domains, zipf_output);
+    eval_zipf<Map<CS::KeyedSkipList, std::string>::type, Map<CS::AdaptiveKeyedSkipList, std::string>::type>("full_path", data_fullpaths, zipf_output);
+#endif
+#ifdef THROUGHPUT_REPORT
+    std::cout << '\n';
+    print_aligned("Structure");
+    std::cout << ',';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Threads");
+    std::cout << ',';
+    print_aligned("OpTime");
+    std::cout << ',';
+    print_aligned("BatchOpTime");
+    std::cout << std::endl;
+
+    std::ostream_iterator<ThroughputResult> throughput_output(std::cout, "\n");
+    eval_throughput<ShardedMapOf<CS::KeyedSkipList, int>::type>("sharded_skiplist", "ip", data_ips, throughput_output);
+    eval_throughput<ShardedMapOf<CS::KeyedSkipList, std::string>::type>("sharded_skiplist", "domain", data_domains, throughput_output);
+    eval_throughput<ShardedMapOf<std::map, int>::type>("sharded_bst", "ip", data_ips, throughput_output);
+    eval_throughput<ShardedMapOf<std::map, std::string>::type>("sharded_bst", "domain", data_domains, throughput_output);
+    eval_throughput<ShardedMapOf<std::unordered_map, int>::type>("sharded_hashmap", "ip", data_ips, throughput_output);
+    eval_throughput<ShardedMapOf<std::unordered_map, std::string>::type>("sharded_hashmap", "domain", data_domains, throughput_output);
+#endif
+#ifdef CACHE_REPORT
+    std::cout << '\n';
+    print_aligned("Structure");
+    std::cout << ',';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Skew");
+    std::cout << ',';
+    print_aligned("HitRatio");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("CachedQuery");
+    std::cout << std::endl;
+
+    std::ostream_iterator<CacheResult> cache_output(std::cout, "\n");
+    eval_cache<Map<CS::KeyedSkipList, int>::type, CachedMapOf<CS::KeyedSkipList, int>::type>("skiplist", "ip", data_ips, cache_output);
+    eval_cache<Map<CS::KeyedSkipList, std::string>::type, CachedMapOf<CS::KeyedSkipList, std::string>::type>("skiplist", "domain", data_domains, cache_output);
+    eval_cache<Map<std::map, std::string>::type, CachedMapOf<std::map, std::string>::type>("bst", "domain", data_domains, cache_output);
+    eval_cache<Map<std::unordered_map, std::string>::type, CachedMapOf<std::unordered_map, std::string>::type>("hashmap", "domain", data_domains, cache_output);
+#endif
+#ifdef BATCH_REPORT
+    std::cout << '\n';
+    print_aligned("Structure");
+    std::cout << ',';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Group");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("BatchQuery");
+    std::cout << std::endl;
+
+    std::ostream_iterator<BatchResult> batch_output(std::cout, "\n");
+    eval_batch<Map<CS::KeyedSkipList, int>::type>("skiplist", "ip", data_ips, batch_output);
+    eval_batch<Map<CS::KeyedSkipList, std::string>::type>("skiplist", "domain", data_domains, batch_output);
+    eval_batch<StaticSkipListMap<int>::type>("static_skiplist", "ip", data_ips, batch_output);
+    eval_batch<Map<std::map, int>::type>("bst", "ip", data_ips, batch_output);
+    eval_batch<Map<std::unordered_map, int>::type>("hashmap", "ip", data_ips, batch_output);
+#endif
+#ifdef SMALL_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("MemoryUsage");
+    std::cout << ',';
+    print_aligned("SmallMemory");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("SmallQuery");
+    std::cout << std::endl;
+
+    std::ostream_iterator<SmallResult> small_output(std::cout, "\n");
+    eval_small<Map<CS::KeyedSkipList, int>::type, SmallSkipListMap<int>::type>("ip", data_ips, small_output);
+    eval_small<Map<CS::KeyedSkipList, std::string>::type, SmallSkipListMap<std::string>::type>("domain", data_domains, small_output);
+#endif
+#ifdef PAGED_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("LeafPages");
+    std::cout << ',';
+    print_aligned("PoolPages");
+    std::cout << ',';
+    print_aligned("Query");
+    std::cout << ',';
+    print_aligned("PagedQuery");
+    std::cout << ',';
+    print_aligned("ReadsPerQuery");
+    std::cout << ',';
+    print_aligned("Scan");
+    std::cout << ',';
+    print_aligned("PagedScan");
+    std::cout << std::endl;
+
+    std::ostream_iterator<PagedResult> paged_output(std::cout, "\n");
+    eval_paged<Map<CS::KeyedSkipList, std::string>::type, CS::PagedSkipList<std::string, int, std::less<std::string>, Random>>("domain", data_domains, paged_output);
+    eval_paged<Map<CS::KeyedSkipList, std::string>::type, CS::PagedSkipList<std::string, int, std::less<std::string>, Random>>("full_path", data_fullpaths, paged_output);
+#endif
+#ifdef LATENCY_REPORT
+    std::cout << '\n';
+    print_aligned("Structure");
+    std::cout << ',';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("InsertP50");
+    std::cout << ',';
+    print_aligned("InsertP99");
+    std::cout << ',';
+    print_aligned("InsertP999");
+    std::cout << ',';
+    print_aligned("QueryP50");
+    std::cout << ',';
+    print_aligned("QueryP99");
+    std::cout << ',';
+    print_aligned("QueryP999");
+    std::cout << ',';
+    print_aligned("EraseP50");
+    std::cout << ',';
+    print_aligned("EraseP99");
+    std::cout << ',';
+    print_aligned("EraseP999");
+    std::cout << std::endl;
+
+    std::ostream_iterator<LatencyResult> latency_output(std::cout, "\n");
+    eval_latency<Map<CS::KeyedSkipList, int>::type>("skiplist", "ip", data_ips, latency_output);
+    eval_latency<Map<CS::DeterministicKeyedSkipList, int>::type>("deterministic_skiplist", "ip", data_ips, latency_output);
+    eval_latency<Map<std::map, int>::type>("bst", "ip", data_ips, latency_output);
+    eval_latency<Map<std::unordered_map, int>::type>("hashmap", "ip", data_ips, latency_output);
+    eval_latency<Map<CS::KeyedSkipList, std::string>::type>("skiplist", "domain", data_domains, latency_output);
+    eval_latency<Map<CS::DeterministicKeyedSkipList, std::string>::type>("deterministic_skiplist", "domain", data_domains, latency_output);
+    eval_latency<Map<std::map, std::string>::type>("bst", "domain", data_domains, latency_output);
+    eval_latency<Map<std::unordered_map, std::string>::type>("hashmap", "domain", data_domains, latency_output);
+#endif
+#ifdef COMPARE_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("TwoWayCompares");
+    std::cout << ',';
+    print_aligned("ThreeWayCompares");
+    std::cout << ',';
+    print_aligned("TwoWayQuery");
+    std::cout << ',';
+    print_aligned("ThreeWayQuery");
+    std::cout << std::endl;
+
+    std::ostream_iterator<CompareResult> compare_output(std::cout, "\n");
+    eval_compare<CompareSkipList<std::string>::type>("domain", data_domains, compare_output);
+    eval_compare<CompareSkipList<std::string>::type>("full_path", data_fullpaths, compare_output);
+#endif
+#ifdef MERGE_REPORT
+    std::cout << '\n';
+    print_aligned("KeyType");
+    std::cout << ',';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Batch");
+    std::cout << ',';
+    print_aligned("Insert");
+    std::cout << ',';
+    print_aligned("Merge");
+    std::cout << std::endl;
+
+    std::ostream_iterator<MergeResult> merge_output(std::cout, "\n");
+    eval_merge<Map<CS::KeyedSkipList, int>::type>("ip", data_ips, merge_output);
+    eval_merge<Map<CS::KeyedSkipList, std::string>::type>("domain", data_domains, merge_output);
+    eval_merge<Map<CS::KeyedSkipList, std::string>::type>("full_path", data_fullpaths, merge_output);
+#endif
+#ifdef PREFIX_REPORT
+    std::cout << '\n';
+    print_aligned("Entries");
+    std::cout << ',';
+    print_aligned("Prefixes");
+    std::cout << ',';
+    print_aligned("EraseIf");
+    std::cout << ',';
+    print_aligned("ErasePrefix");
+    std::cout << std::endl;
+
+    std::ostream_iterator<PrefixResult> prefix_output(std::cout, "\n");
+    eval_prefix<Map<CS::KeyedSkipList, std::string>::type>(data_fullpaths, prefix_output);
+#endif
 }
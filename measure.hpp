@@ -1,13 +1,23 @@
 #pragma once
 
+#include "batch_lookup.hpp"
+#include "counting_compare.hpp"
 #include "data.hpp"
+#include "load.hpp"
 #include "measuring_allocator.hpp"
 
+#include "CSParallel.h"
+
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <numeric>
 #include <random>
 #include <set>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 
 template<typename Clock, typename F>
 time_unit time(F&& fun) {
@@ -16,19 +26,77 @@ time_unit time(F&& fun) {
     return Clock::now() - start;
 }
 
+// Sets hold the key alone, maps pair it with a dummy value.
+template<typename Map, typename K>
+typename Map::value_type make_entry(K const& key, std::true_type) {
+    return key;
+}
+
+template<typename Map, typename K>
+typename Map::value_type make_entry(K const& key, std::false_type) {
+    return {key, 0};
+}
+
+template<typename Map, typename K>
+typename Map::value_type make_entry(K const& key) {
+    return make_entry<Map>(key, std::is_same<typename Map::key_type, typename Map::value_type>{});
+}
+
 template<typename Map, typename RAIter>
 void fill_map(Map& map, RAIter begin, RAIter end) {
-    std::for_each(begin, end, [&](auto x) { map.insert(std::make_pair(x, 0)); });
+    std::for_each(begin, end, [&](auto x) { map.insert(make_entry<Map>(x)); });
 }
 
-template<typename Map, typename Clock, typename RAIter>
-time_unit eval_map_insertion(RAIter begin, RAIter end) {
+template<typename Map, typename K>
+bool contains(Map const& map, K const& key, ...) {
+    return map.find(key) != map.end();
+}
+
+// Maps whose lookups cannot hand out iterators answer through contains().
+template<typename Map, typename K>
+auto contains(Map const& map, K const& key, int) -> decltype(map.contains(key)) {
+    return map.contains(key);
+}
+
+template<typename Map>
+StructureStats structure_stats(Map const&, ...) {
+    return {};
+}
+
+// Nodes per level are joined with '/', lowest level first.
+template<typename Map>
+auto structure_stats(Map const& map, int) -> decltype(map.stats(), StructureStats{}) {
+    auto const s = map.stats();
+    StructureStats result;
+    for (std::size_t i = 0; i <= s.level; ++i)
+        result.level_histogram += (i ? "/" : "") + std::to_string(s.nodesPerLevel[i]);
+    result.average_path = s.averagePath;
+    result.max_path = s.maxPath;
+    result.node_bytes = s.nodeBytes;
+    result.pointer_bytes = s.pointerBytes;
+    result.sentinel_bytes = s.sentinelBytes;
+    result.update_bytes = s.updateBytes;
+    return result;
+}
+
+template<typename Map, typename RAIter>
+StructureStats eval_map_stats(RAIter begin, RAIter end) {
+    Map stats_map;
+    fill_map(stats_map, begin, end);
+    return structure_stats(stats_map, 0);
+}
+
+// The eval_map_* functions pass any trailing arguments on to the map's
+// constructor.
+
+template<typename Map, typename Clock, typename RAIter, typename... Args>
+time_unit eval_map_insertion(RAIter begin, RAIter end, Args const&... args) {
 #ifdef SKIP_INSERTION
     return {};
 #endif
     time_unit t{};
     for (int i = 0; i < REPEAT_COUNT; ++i) {
-        Map ins_map;
+        Map ins_map(args...);
         t += time<Clock>([&]() {
             fill_map(ins_map, begin, end);
         });
@@ -36,24 +104,29 @@ time_unit eval_map_insertion(RAIter begin, RAIter end) {
     return t / REPEAT_COUNT;
 }
 
-template<typename Map, typename Clock, typename RAIter>
-time_unit eval_map_query(RAIter begin, RAIter end) {
+template<typename Map, typename Clock, typename RAIter, typename... Args>
+time_unit eval_map_query(RAIter begin, RAIter end, Args const&... args) {
 #ifdef SKIP_QUERY
     return {};
 #endif
-    Map query_map;
+    Map query_map(args...);
     fill_map(query_map, begin, end);
-    return time<Clock>([&]() {
+    // Counting the hits keeps the compiler from dropping the lookups.
+    std::size_t found = 0;
+    auto const t = time<Clock>([&]() {
         for (int i = 0; i < REPEAT_COUNT; ++i) {
-            std::for_each(begin, end, [&](auto x) { query_map.find(x); });
+            std::for_each(begin, end, [&](auto x) { found += contains(query_map, x, 0); });
         }
     }) / REPEAT_COUNT;
+    if (found != query_map.size() * REPEAT_COUNT)
+        throw std::runtime_error("query missed elements");
+    return t;
 }
 
-template<typename Map, typename Clock, typename RAIter>
-std::size_t eval_map_memory_usage(RAIter begin, RAIter end) {
+template<typename Map, typename Clock, typename RAIter, typename... Args>
+std::size_t eval_map_memory_usage(RAIter begin, RAIter end, Args const&... args) {
     reset_allocated();
-    Map memory_map;
+    Map memory_map(args...);
     fill_map(memory_map, begin, end);
     return get_allocated();
 }
@@ -74,6 +147,639 @@ std::set<T> random_subset(std::vector<T> const& vec, std::size_t size) {
     return result;
 }
 
+// Takes elements of vec that are not in present, for negative lookups.
+template<typename T>
+std::vector<T> absent_subset(std::vector<T> const& vec, std::set<T> const& present, std::size_t size) {
+    std::vector<T> result;
+    for (auto const& x : vec) {
+        if (result.size() == size)
+            return result;
+        if (!present.count(x))
+            result.push_back(x);
+    }
+    throw std::runtime_error("not enough data");
+}
+
+template<typename Map, typename Clock, typename RAIter>
+time_unit eval_map_miss_query(Map const& map, RAIter begin, RAIter end) {
+    return time<Clock>([&]() {
+        for (int i = 0; i < REPEAT_COUNT; ++i) {
+            std::for_each(begin, end, [&](auto x) { map.find(x); });
+        }
+    }) / REPEAT_COUNT;
+}
+
+// Measures the false positive rate and memory of the skip list's membership
+// filter for a few target rates, and what it saves on lookups that miss.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_filter(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    for (std::size_t i = 8; i < 14; ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        auto const absent = absent_subset(data, subset, elements);
+        Map map;
+        fill_map(map, subset.begin(), subset.end());
+        auto const miss_time = eval_map_miss_query<Map, clock>(map, absent.begin(), absent.end());
+        for (double rate : {0.1, 0.01, 0.001}) {
+            map.enable_filter(elements, rate);
+            auto const filter = map.filter();
+            auto const positives = std::count_if(absent.begin(), absent.end(), [&](auto x) { return filter->contains(x); });
+            auto const filtered_miss_time = eval_map_miss_query<Map, clock>(map, absent.begin(), absent.end());
+            *out = {key_type, elements, rate, double(positives) / absent.size(), filter->memory_usage(), miss_time, filtered_miss_time};
+            ++out;
+        }
+        map.disable_filter();
+    }
+}
+
+// Times a full parallel pass over the map for every thread count up to the
+// number of cores, on maps larger than the ones eval_structure uses.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_parallel_scan(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    unsigned int const cores = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 14; i < 21 && (std::size_t(1) << i) <= data.size(); ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        Map map;
+        fill_map(map, subset.begin(), subset.end());
+        Map const& cmap = map;
+        for (unsigned int threads = 1; threads <= cores; threads *= 2) {
+            CS::WorkStealingPool pool(threads);
+            std::size_t found = 0;
+            auto const scan_time = time<clock>([&]() {
+                for (int r = 0; r < REPEAT_COUNT; ++r)
+                    found += CS::parallel_count_if(cmap, [](auto const& x) { return x.second == 0; }, pool);
+            }) / REPEAT_COUNT;
+            if (found != elements * REPEAT_COUNT)
+                throw std::runtime_error("parallel scan missed elements");
+            *out = {key_type, elements, threads, scan_time};
+            ++out;
+        }
+    }
+}
+
+// Compares inserting unsorted input one element at a time with building the
+// map through parallel_build, for every thread count up to the number of cores.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_build(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    unsigned int const cores = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 14; i < 21 && (std::size_t(1) << i) <= data.size(); ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{std::random_device{}()});
+        std::vector<typename Map::value_type> values;
+        for (auto const& x : keys)
+            values.emplace_back(x, 0);
+
+        time_unit insertion_time{};
+        for (int r = 0; r < REPEAT_COUNT; ++r) {
+            Map map;
+            insertion_time += time<clock>([&]() {
+                map.insert(values.begin(), values.end());
+            });
+        }
+        insertion_time /= REPEAT_COUNT;
+
+        for (unsigned int threads = 1; threads <= cores; threads *= 2) {
+            CS::WorkStealingPool pool(threads);
+            time_unit build_time{};
+            for (int r = 0; r < REPEAT_COUNT; ++r) {
+                Map map;
+                build_time += time<clock>([&]() {
+                    CS::parallel_build(map, values.begin(), values.end(), pool);
+                });
+                if (map.size() != elements)
+                    throw std::runtime_error("parallel build lost elements");
+            }
+            *out = {key_type, elements, threads, insertion_time, build_time / REPEAT_COUNT};
+            ++out;
+        }
+    }
+}
+
+// Erases every other key of a full map, once freeing nodes right away and
+// once lazily, then times compact() and lookups of the surviving keys with
+// and without the tombstones still linked.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_lazy_erase(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    for (std::size_t i = 8; i < 14; ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        std::vector<T> erased, kept;
+        for (auto const& x : subset)
+            ((erased.size() == kept.size()) ? erased : kept).push_back(x);
+
+        LazyResult result{key_type, elements, {}, {}, {}, {}, {}};
+        for (int r = 0; r < REPEAT_COUNT; ++r) {
+            Map eager, lazy;
+            fill_map(eager, subset.begin(), subset.end());
+            fill_map(lazy, subset.begin(), subset.end());
+            lazy.lazy_erase(true);
+            result.erase_time += time<clock>([&]() {
+                for (auto const& x : erased)
+                    eager.erase(x);
+            });
+            result.lazy_erase_time += time<clock>([&]() {
+                for (auto const& x : erased)
+                    lazy.erase(x);
+            });
+            std::size_t found = 0;
+            result.tombstone_query_time += time<clock>([&]() {
+                for (auto const& x : kept)
+                    found += lazy.find(x) != lazy.end();
+            });
+            result.compact_time += time<clock>([&]() {
+                lazy.compact();
+            });
+            result.query_time += time<clock>([&]() {
+                for (auto const& x : kept)
+                    found += lazy.find(x) != lazy.end();
+            });
+            if (found != 2 * kept.size())
+                throw std::runtime_error("lazy erase lost elements");
+        }
+        result.erase_time /= REPEAT_COUNT;
+        result.lazy_erase_time /= REPEAT_COUNT;
+        result.compact_time /= REPEAT_COUNT;
+        result.query_time /= REPEAT_COUNT;
+        result.tombstone_query_time /= REPEAT_COUNT;
+        *out = result;
+        ++out;
+    }
+}
+
+// Sweeps the level probability and maximum level of a skiplist.  For every
+// size all settings are measured first, then each row is flagged when no
+// other setting is at least as good on insert, query and memory and better
+// on one of them.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_tuning(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    using MemMeasureMap = MapTmpl<MeasuringAllocator>;
+    double const probabilities[] = {0.5, 0.368, 0.25, 0.125, 0.0625};
+    for (std::size_t i = 8; i < 14; ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        std::vector<TuneResult> results;
+        for (double p : probabilities) {
+            // Enough levels to expect one node on the top level, then fewer and more.
+            std::size_t const natural = std::max(1.0, std::ceil(std::log(double(elements)) / std::log(1 / p)) - 1);
+            for (std::size_t max_level : {std::max<std::size_t>(1, natural / 2), natural, natural + 2}) {
+                TuneResult r{key_type, elements, p, max_level, {}, {}, 0, false};
+                r.memory_usage = eval_map_memory_usage<MemMeasureMap, clock>(subset.begin(), subset.end(), p, max_level);
+                r.insertion_time = eval_map_insertion<Map, clock>(subset.begin(), subset.end(), p, max_level);
+                r.query_time = eval_map_query<Map, clock>(subset.begin(), subset.end(), p, max_level);
+                results.push_back(r);
+            }
+        }
+        for (auto& r : results) {
+            r.pareto = std::none_of(results.begin(), results.end(), [&](TuneResult const& o) {
+                bool const no_worse = o.insertion_time <= r.insertion_time && o.query_time <= r.query_time && o.memory_usage <= r.memory_usage;
+                bool const better = o.insertion_time < r.insertion_time || o.query_time < r.query_time || o.memory_usage < r.memory_usage;
+                return no_worse && better;
+            });
+        }
+        out = std::copy(results.begin(), results.end(), out);
+    }
+}
+
+// Replays a Zipf distributed lookup trace against a plain and an adaptive
+// map.  The adaptive map sees the trace once and adapts before it is timed.
+template<template<template<typename> class> class MapTmpl, template<template<typename> class> class AdaptiveTmpl, typename T, typename OutIter>
+void eval_zipf(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    using AdaptiveMap = AdaptiveTmpl<std::allocator>;
+    for (std::size_t i = 10; i < 14; ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        // Shuffled, so popularity has nothing to do with key order.
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{std::random_device{}()});
+        for (double skew : {0.8, 1.0, 1.2}) {
+            std::vector<T> trace;
+            for (auto x : make_zipf_indices(elements, 64 * elements, skew))
+                trace.push_back(keys[x]);
+
+            Map map;
+            AdaptiveMap adaptive;
+            fill_map(map, subset.begin(), subset.end());
+            fill_map(adaptive, subset.begin(), subset.end());
+            for (auto const& x : trace)
+                adaptive.find(x);
+            auto const adapt_time = time<clock>([&]() { adaptive.adapt(); });
+
+            std::size_t found = 0;
+            auto const query_time = time<clock>([&]() {
+                for (auto const& x : trace)
+                    found += map.find(x) != map.end();
+            });
+            auto const adaptive_query_time = time<clock>([&]() {
+                for (auto const& x : trace)
+                    found += adaptive.find(x) != adaptive.end();
+            });
+            if (found != 2 * trace.size())
+                throw std::runtime_error("zipf trace missed elements");
+            *out = {key_type, elements, skew, query_time, adaptive_query_time, adapt_time};
+            ++out;
+        }
+    }
+}
+
+// Looks up a random trace one key at a time and then through batch_contains()
+// with growing group sizes, reporting the time per lookup.  The larger maps
+// do not fit in cache, which is where overlapping the misses pays off.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_batch(std::string structure_name, std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    std::size_t const lookups = 1 << 18;
+    for (std::size_t i : {12, 16, 20}) {
+        std::size_t const elements = std::size_t(1) << i;
+        if (elements > data.size())
+            break;
+        auto const subset = random_subset(data, elements);
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::mt19937 engine{std::random_device{}()};
+        std::shuffle(keys.begin(), keys.end(), engine);
+        MapTmpl<std::allocator> map;
+        fill_map(map, keys.begin(), keys.end());
+
+        std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+        std::vector<T> trace;
+        for (std::size_t j = 0; j < lookups; ++j)
+            trace.push_back(keys[pick(engine)]);
+
+        std::size_t found = 0;
+        auto const query_time = time<clock>([&]() {
+            for (auto const& x : trace)
+                found += contains(map, x, 0);
+        }) / lookups;
+        std::vector<char> results(lookups);
+        for (std::size_t group : {1, 2, 4, 8, 16, 32}) {
+            auto const batch_query_time = time<clock>([&]() {
+                batch_contains(map, trace.begin(), trace.end(), results.begin(), group);
+            }) / lookups;
+            found += std::accumulate(results.begin(), results.end(), std::size_t(0));
+            *out = {structure_name, key_type, elements, group, query_time, batch_query_time};
+            ++out;
+        }
+        if (found != 7 * lookups)
+            throw std::runtime_error("batched lookups missed elements");
+    }
+}
+
+// Looks keys up in skiplists ordered by two-way and by three-way
+// comparators.  Counting comparators give the comparisons per lookup, plain
+// ones the time.  ListOf<Compare> is the skiplist type for a comparator.
+template<template<typename> class ListOf, typename T, typename OutIter>
+void eval_compare(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    std::size_t const lookups = 1 << 18;
+    for (std::size_t i : {12, 16, 20}) {
+        std::size_t const elements = std::size_t(1) << i;
+        if (elements > data.size())
+            break;
+        auto const subset = random_subset(data, elements);
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::mt19937 engine{std::random_device{}()};
+        std::shuffle(keys.begin(), keys.end(), engine);
+        std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+        std::vector<T> trace;
+        for (std::size_t j = 0; j < lookups; ++j)
+            trace.push_back(keys[pick(engine)]);
+
+        std::size_t found = 0;
+        auto const count = [&](auto& map) {
+            fill_map(map, keys.begin(), keys.end());
+            comparison_count() = 0;
+            for (auto const& x : trace)
+                found += contains(map, x, 0);
+            return static_cast<double>(comparison_count()) / lookups;
+        };
+        auto const measure = [&](auto& map) {
+            fill_map(map, keys.begin(), keys.end());
+            return time<clock>([&]() {
+                for (auto const& x : trace)
+                    found += contains(map, x, 0);
+            }) / lookups;
+        };
+
+        ListOf<CountingLess<T>> counted_two_way;
+        ListOf<CountingCompare<T>> counted_three_way;
+        ListOf<TwoWayLess<T>> two_way;
+        ListOf<std::less<T>> three_way;
+        CompareResult result{key_type, elements, 0, 0, {}, {}};
+        result.two_way_comparisons = count(counted_two_way);
+        result.three_way_comparisons = count(counted_three_way);
+        result.two_way_query_time = measure(two_way);
+        result.three_way_query_time = measure(three_way);
+        if (found != 4 * lookups)
+            throw std::runtime_error("comparison run missed elements");
+        *out = result;
+        ++out;
+    }
+}
+
+// Sorts the samples and returns the one below which `fraction` of them fall.
+inline time_unit percentile(std::vector<time_unit>& samples, double fraction) {
+    std::sort(samples.begin(), samples.end());
+    auto const rank = static_cast<std::size_t>(std::ceil(fraction * samples.size()));
+    return samples[std::max<std::size_t>(rank, 1) - 1];
+}
+
+// Times every insert, lookup and erase on its own, so a slow operation
+// shows up in the tail instead of vanishing into an average.  Each clock
+// read costs a few dozen nanoseconds, which is in every sample alike.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_latency(std::string structure_name, std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    std::size_t const lookups = 1 << 18;
+    for (std::size_t i : {12, 16, 20}) {
+        std::size_t const elements = std::size_t(1) << i;
+        if (elements > data.size())
+            break;
+        auto const subset = random_subset(data, elements);
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::mt19937 engine{std::random_device{}()};
+        std::shuffle(keys.begin(), keys.end(), engine);
+
+        MapTmpl<std::allocator> map;
+        std::vector<time_unit> insert_times;
+        insert_times.reserve(elements);
+        for (auto const& x : keys)
+            insert_times.push_back(time<clock>([&]() { map.insert(std::make_pair(x, 0)); }));
+
+        std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+        std::vector<time_unit> query_times;
+        query_times.reserve(lookups);
+        std::size_t found = 0;
+        for (std::size_t j = 0; j < lookups; ++j) {
+            auto const& x = keys[pick(engine)];
+            query_times.push_back(time<clock>([&]() { found += contains(map, x, 0); }));
+        }
+
+        std::shuffle(keys.begin(), keys.end(), engine);
+        std::vector<time_unit> erase_times;
+        erase_times.reserve(elements);
+        for (auto const& x : keys)
+            erase_times.push_back(time<clock>([&]() { found += map.erase(x); }));
+        if (found != lookups + elements || !map.empty())
+            throw std::runtime_error("latency run lost elements");
+
+        *out = {structure_name, key_type, elements,
+                percentile(insert_times, 0.5), percentile(insert_times, 0.99), percentile(insert_times, 0.999),
+                percentile(query_times, 0.5), percentile(query_times, 0.99), percentile(query_times, 0.999),
+                percentile(erase_times, 0.5), percentile(erase_times, 0.99), percentile(erase_times, 0.999)};
+        ++out;
+    }
+}
+
+// Builds many tiny maps of each size and reports the bytes one map costs,
+// its own size included, and the time per lookup over all of them.
+template<template<template<typename> class> class MapTmpl, template<template<typename> class> class SmallTmpl, typename T, typename OutIter>
+void eval_small(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    std::size_t const maps = 1024;
+    for (std::size_t elements : {0, 1, 4, 8, 16, 32}) {
+        auto const subset = random_subset(data, std::max<std::size_t>(elements * maps, 1));
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{std::random_device{}()});
+
+        auto const measure = [&](auto& instances, std::size_t& memory_usage) {
+            reset_allocated();
+            instances.resize(maps);
+            for (std::size_t m = 0; m < maps; ++m)
+                fill_map(instances[m], keys.begin() + m * elements, keys.begin() + (m + 1) * elements);
+            memory_usage = get_allocated() / maps + sizeof(instances[0]);
+
+            std::size_t found = 0;
+            auto const t = time<clock>([&]() {
+                for (int i = 0; i < REPEAT_COUNT; ++i)
+                    for (std::size_t m = 0; m < maps; ++m)
+                        for (std::size_t k = m * elements; k < (m + 1) * elements; ++k)
+                            found += contains(instances[m], keys[k], 0);
+            });
+            if (found != elements * maps * REPEAT_COUNT)
+                throw std::runtime_error("small map query missed elements");
+            return elements == 0 ? time_unit{} : time_unit(t / (elements * maps * REPEAT_COUNT));
+        };
+
+        std::vector<MapTmpl<MeasuringAllocator>> plain;
+        std::vector<SmallTmpl<MeasuringAllocator>> small;
+        std::size_t memory_usage = 0, small_memory_usage = 0;
+        auto const query_time = measure(plain, memory_usage);
+        auto const small_query_time = measure(small, small_memory_usage);
+        *out = {key_type, elements, memory_usage, small_memory_usage, query_time, small_query_time};
+        ++out;
+    }
+}
+
+// Puts every key in a file-backed skiplist and compares random lookups and
+// 64 key range scans with the in-memory map while the buffer pool holds all,
+// a half and a quarter of the leaf pages.  The file stays in the OS page
+// cache, so this measures the pool's misses rather than real disk latency.
+template<template<template<typename> class> class MapTmpl, typename Paged, typename T, typename OutIter>
+void eval_paged(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    std::size_t const lookups = 1 << 16;
+    std::size_t const scans = 1 << 10;
+    std::size_t const scan_length = 64;
+    std::string const path = "paged_" + key_type + ".db";
+
+    std::set<T> const unique(data.begin(), data.end());
+    std::vector<T> const sorted(unique.begin(), unique.end());
+    std::mt19937 engine{std::random_device{}()};
+    std::uniform_int_distribution<std::size_t> pick(0, sorted.size() - 1);
+    std::vector<T> trace, scan_from, scan_to;
+    for (std::size_t i = 0; i < lookups; ++i)
+        trace.push_back(sorted[pick(engine)]);
+    for (std::size_t i = 0; i < scans; ++i) {
+        std::size_t const from = pick(engine);
+        scan_from.push_back(sorted[from]);
+        scan_to.push_back(sorted[std::min(from + scan_length, sorted.size() - 1)]);
+    }
+
+    std::vector<T> keys(sorted);
+    std::shuffle(keys.begin(), keys.end(), engine);
+    std::remove(path.c_str());
+    std::size_t leaf_pages;
+    {
+        Paged paged(path.c_str(), keys.size());
+        fill_map(paged, keys.begin(), keys.end());
+        leaf_pages = paged.leaf_page_count();
+    }
+
+    MapTmpl<std::allocator> map;
+    fill_map(map, keys.begin(), keys.end());
+    std::size_t found = 0;
+    auto const query_time = time<clock>([&]() {
+        for (auto const& x : trace)
+            found += contains(map, x, 0);
+    });
+    auto const scan_time = time<clock>([&]() {
+        for (std::size_t i = 0; i < scans; ++i)
+            for (auto it = map.lower_bound(scan_from[i]); it != map.end() && it->first < scan_to[i]; ++it)
+                found += it->second == 0;
+    });
+
+    for (std::size_t ratio : {1, 2, 4}) {
+        Paged paged(path.c_str(), std::max<std::size_t>(leaf_pages / ratio, 1));
+        // One pass to fill the pool, then the timed pass.
+        for (auto const& x : trace)
+            paged.contains(x);
+        auto const reads = paged.page_reads();
+        auto const paged_query_time = time<clock>([&]() {
+            for (auto const& x : trace)
+                found += paged.contains(x);
+        });
+        double const reads_per_query = double(paged.page_reads() - reads) / lookups;
+        auto const paged_scan_time = time<clock>([&]() {
+            for (std::size_t i = 0; i < scans; ++i)
+                paged.scan(scan_from[i], scan_to[i], [&](T const&, int value) { found += value == 0; });
+        });
+        *out = {key_type, sorted.size(), leaf_pages, paged.pool_pages(), query_time, paged_query_time, reads_per_query, scan_time, paged_scan_time};
+        ++out;
+    }
+    std::remove(path.c_str());
+    if (found < 4 * lookups)
+        throw std::runtime_error("paged lookups missed elements");
+}
+
+// Replays a Zipf distributed lookup trace against a map with and without a
+// verdict cache in front of it, and reports the cache's hit ratio.
+template<template<template<typename> class> class MapTmpl, template<template<typename> class> class CachedTmpl, typename T, typename OutIter>
+void eval_cache(std::string structure_name, std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    using CachedMap = CachedTmpl<std::allocator>;
+    for (std::size_t i = 10; i < 14; ++i) {
+        std::size_t const elements = 1 << i;
+        auto const subset = random_subset(data, elements);
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{std::random_device{}()});
+        for (double skew : {0.8, 1.0, 1.2}) {
+            std::vector<T> trace;
+            for (auto x : make_zipf_indices(elements, 64 * elements, skew))
+                trace.push_back(keys[x]);
+
+            Map map;
+            CachedMap cached;
+            fill_map(map, subset.begin(), subset.end());
+            fill_map(cached, subset.begin(), subset.end());
+
+            std::size_t found = 0;
+            auto const query_time = time<clock>([&]() {
+                for (auto const& x : trace)
+                    found += contains(map, x, 0);
+            });
+            auto const cached_query_time = time<clock>([&]() {
+                for (auto const& x : trace)
+                    found += contains(cached, x, 0);
+            });
+            if (found != 2 * trace.size())
+                throw std::runtime_error("cache trace missed elements");
+            double const hit_ratio = double(cached.cache_hits()) / (cached.cache_hits() + cached.cache_misses());
+            *out = {structure_name, key_type, elements, skew, hit_ratio, query_time, cached_query_time};
+            ++out;
+        }
+    }
+}
+
+// Runs a 90% lookup, 10% insert mix on one shared map from every thread
+// count up to the number of cores, once with single operations and once
+// with the same operations in batches of 64.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_throughput(std::string structure_name, std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    using value_type = typename Map::value_type;
+    std::size_t const batch = 64;
+    std::size_t const ops_per_thread = 1 << 16;
+    std::size_t elements = 1 << 16;
+    while (elements > data.size())
+        elements /= 2;
+    auto const subset = random_subset(data, elements);
+    std::vector<T> keys(subset.begin(), subset.end());
+    std::mt19937 engine{std::random_device{}()};
+    std::shuffle(keys.begin(), keys.end(), engine);
+    std::vector<value_type> present, added;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        (i % 2 ? added : present).emplace_back(keys[i], 0);
+
+    unsigned int const cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads <= cores; threads *= 2) {
+        // Every thread gets its own batches of lookups and inserts, and its
+        // own slice of the added keys, so each insert adds a new element
+        // until the slices wrap around.
+        std::vector<std::vector<T>> lookups(threads);
+        std::vector<std::vector<value_type>> inserts(threads);
+        std::uniform_int_distribution<std::size_t> pick(0, present.size() - 1);
+        std::size_t const inserts_per_thread = ops_per_thread / 10;
+        for (unsigned int t = 0; t < threads; ++t) {
+            for (std::size_t i = 0; i < ops_per_thread; ++i) {
+                if (i % 10 == 9)
+                    inserts[t].push_back(added[(t * inserts_per_thread + inserts[t].size()) % added.size()]);
+                else
+                    lookups[t].push_back(present[pick(engine)].first);
+            }
+        }
+
+        auto const run = [&](bool batched) {
+            Map map;
+            map.insert(present.begin(), present.end());
+            std::vector<std::thread> workers;
+            // Counting the hits keeps the compiler from dropping the lookups.
+            std::vector<std::size_t> found(threads);
+            auto const t = time<clock>([&]() {
+                for (unsigned int w = 0; w < threads; ++w) {
+                    workers.emplace_back([&, w]() {
+                        auto const& l = lookups[w];
+                        auto const& ins = inserts[w];
+                        std::vector<typename Map::lookup_type> results(batch);
+                        // The inserts are spread over the lookup batches so
+                        // that all of them run by the last batch.
+                        for (std::size_t i = 0; i < l.size(); i += batch) {
+                            std::size_t const n = std::min(batch, l.size() - i);
+                            std::size_t const j = ins.size() * i / l.size();
+                            std::size_t const m = ins.size() * (i + n) / l.size() - j;
+                            if (batched) {
+                                map.find(l.begin() + i, l.begin() + i + n, results.begin());
+                                for (std::size_t k = 0; k < n; ++k)
+                                    found[w] += results[k].second;
+                                map.insert(ins.begin() + j, ins.begin() + j + m);
+                            } else {
+                                for (std::size_t k = 0; k < n; ++k)
+                                    found[w] += map.find(l[i + k]).second;
+                                for (std::size_t k = 0; k < m; ++k)
+                                    map.insert(ins[j + k]);
+                            }
+                        }
+                    });
+                }
+                for (auto& worker : workers)
+                    worker.join();
+            });
+            if (std::accumulate(found.begin(), found.end(), std::size_t(0)) != lookups.size() * lookups[0].size())
+                throw std::runtime_error("throughput query missed elements");
+            return t / (ops_per_thread * threads);
+        };
+        auto const op_time = run(false);
+        auto const batch_op_time = run(true);
+        *out = {structure_name, key_type, elements, threads, op_time, batch_op_time};
+        ++out;
+    }
+}
+
 template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
 std::vector<Result> eval_structure(std::string structure_name, std::string key_type, std::vector<T> const& data, OutIter out) {
     using clock = std::chrono::high_resolution_clock;
@@ -86,9 +792,89 @@ std::vector<Result> eval_structure(std::string structure_name, std::string key_t
         auto const memory_usage = eval_map_memory_usage<MemMeasureMap, clock>(subset.begin(), subset.end());
         auto const insert_result = eval_map_insertion<Map, clock>(subset.begin(), subset.end());
         auto const query_result = eval_map_query<Map, clock>(subset.begin(), subset.end());
-        *out = {structure_name, key_type, elements, insert_result, query_result, memory_usage};
+        auto const stats = eval_map_stats<Map>(subset.begin(), subset.end());
+        *out = {structure_name, key_type, elements, insert_result, query_result, memory_usage, stats};
         ++out;
     }
     return results;
 }
 
+// Adds a shuffled batch to a full map, once through insert(first, last) and
+// once through insert_batch(), starting from the same copy each time.  A
+// fifth of the batch is already in the map.
+template<template<template<typename> class> class MapTmpl, typename T, typename OutIter>
+void eval_merge(std::string key_type, std::vector<T> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    for (std::size_t i : {16, 20}) {
+        std::size_t const elements = std::size_t(1) << i;
+        std::size_t const fresh = elements / 4;
+        if (elements + fresh > data.size())
+            break;
+        auto const subset = random_subset(data, elements + fresh);
+        std::vector<T> keys(subset.begin(), subset.end());
+        std::mt19937 engine{std::random_device{}()};
+        std::shuffle(keys.begin(), keys.end(), engine);
+        Map base;
+        fill_map(base, keys.begin(), keys.begin() + elements);
+
+        std::vector<T> batch_keys(keys.begin() + elements, keys.end());
+        batch_keys.insert(batch_keys.end(), keys.begin(), keys.begin() + fresh / 4);
+        std::shuffle(batch_keys.begin(), batch_keys.end(), engine);
+        std::vector<typename Map::value_type> batch;
+        for (auto const& x : batch_keys)
+            batch.emplace_back(x, 0);
+
+        Map inserted(base);
+        auto const insertion_time = time<clock>([&]() {
+            inserted.insert(batch.begin(), batch.end());
+        });
+        Map merged(base);
+        auto const merge_time = time<clock>([&]() {
+            merged.insert_batch(batch.begin(), batch.end());
+        });
+        if (inserted.size() != elements + fresh || merged.size() != inserted.size())
+            throw std::runtime_error("batch insert lost elements");
+        *out = {key_type, elements, batch.size(), insertion_time / batch.size(), merge_time / batch.size()};
+        ++out;
+    }
+}
+
+// Drops every full path under a number of domains from a map of all paths,
+// once through erase_if() and once through erase_prefix().  The domain is
+// the path up to and including its first '/'.
+template<template<template<typename> class> class MapTmpl, typename OutIter>
+void eval_prefix(std::vector<std::string> const& data, OutIter out) {
+    using clock = std::chrono::high_resolution_clock;
+    using Map = MapTmpl<std::allocator>;
+    Map base;
+    fill_map(base, data.begin(), data.end());
+    std::vector<std::string> domains;
+    for (auto const& x : base)
+        if (domains.empty() || x.first.compare(0, domains.back().size(), domains.back()) != 0)
+            domains.push_back(x.first.substr(0, x.first.find('/') + 1));
+    std::shuffle(domains.begin(), domains.end(), std::mt19937{std::random_device{}()});
+
+    for (std::size_t prefixes : {1, 16, 256}) {
+        if (prefixes > domains.size())
+            break;
+        Map filtered(base);
+        auto const erase_if_time = time<clock>([&]() {
+            for (std::size_t j = 0; j < prefixes; ++j) {
+                auto const& prefix = domains[j];
+                filtered.erase_if([&](typename Map::value_type const& x) {
+                    return x.first.compare(0, prefix.size(), prefix) == 0;
+                });
+            }
+        });
+        Map cut(base);
+        auto const erase_prefix_time = time<clock>([&]() {
+            for (std::size_t j = 0; j < prefixes; ++j)
+                cut.erase_prefix(domains[j]);
+        });
+        if (cut.size() != filtered.size() || cut.size() == base.size())
+            throw std::runtime_error("prefix erase kept the wrong paths");
+        *out = {base.size(), prefixes, erase_if_time / prefixes, erase_prefix_time / prefixes};
+        ++out;
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+// Splits a map into N independently locked shards, picked by hashing the
+// key, so threads working on different shards never wait on each other.
+// Iterators cannot outlive a shard's lock, so lookups return a copy of the
+// mapped value.
+template<typename Inner, std::size_t N, typename Hash = std::hash<typename Inner::key_type>>
+class ShardedMap {
+public:
+    using key_type = typename Inner::key_type;
+    using mapped_type = typename Inner::mapped_type;
+    using value_type = typename Inner::value_type;
+    using size_type = std::size_t;
+    using lookup_type = std::pair<mapped_type, bool>;
+
+    static_assert(N > 0, "ShardedMap needs at least one shard");
+
+    bool insert(value_type const& value) {
+        auto& shard = shard_for(value.first);
+        std::lock_guard<std::shared_timed_mutex> guard(shard.lock);
+        return shard.map.insert(value).second;
+    }
+
+    // Takes each shard's lock once for all of its elements.
+    template<typename InIter>
+    void insert(InIter begin, InIter end) {
+        std::vector<value_type const*> values;
+        for (auto it = begin; it != end; ++it)
+            values.push_back(&*it);
+        auto const order = group_by_shard(values.size(), [&](std::size_t k) { return values[k]->first; });
+        for (std::size_t i = 0; i < N; ++i) {
+            if (order.first[i] == order.first[i + 1])
+                continue;
+            std::lock_guard<std::shared_timed_mutex> guard(shards[i].lock);
+            for (std::size_t j = order.first[i]; j < order.first[i + 1]; ++j)
+                shards[i].map.insert(*values[order.second[j]]);
+        }
+    }
+
+    size_type erase(key_type const& key) {
+        auto& shard = shard_for(key);
+        std::lock_guard<std::shared_timed_mutex> guard(shard.lock);
+        return shard.map.erase(key);
+    }
+
+    lookup_type find(key_type const& key) const {
+        auto const& shard = shard_for(key);
+        std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return {mapped_type(), false};
+        return {it->second, true};
+    }
+
+    bool contains(key_type const& key) const {
+        return find(key).second;
+    }
+
+    // Writes one lookup_type per key, in input order, taking each shard's
+    // lock once for all of its keys.
+    template<typename InIter, typename OutIter>
+    OutIter find(InIter begin, InIter end, OutIter out) const {
+        std::vector<key_type const*> keys;
+        for (auto it = begin; it != end; ++it)
+            keys.push_back(&*it);
+        auto const order = group_by_shard(keys.size(), [&](std::size_t k) { return *keys[k]; });
+        std::vector<lookup_type> results(keys.size());
+        for (std::size_t i = 0; i < N; ++i) {
+            if (order.first[i] == order.first[i + 1])
+                continue;
+            std::shared_lock<std::shared_timed_mutex> guard(shards[i].lock);
+            for (std::size_t j = order.first[i]; j < order.first[i + 1]; ++j) {
+                auto const k = order.second[j];
+                auto it = shards[i].map.find(*keys[k]);
+                if (it != shards[i].map.end())
+                    results[k] = {it->second, true};
+            }
+        }
+        return std::copy(results.begin(), results.end(), out);
+    }
+
+    size_type size() const {
+        size_type total = 0;
+        for (auto const& shard : shards) {
+            std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+            total += shard.map.size();
+        }
+        return total;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    // The padding keeps the lock and map of neighbouring shards off each
+    // other's cache lines without relying on over-aligned allocation.
+    struct Shard {
+        mutable std::shared_timed_mutex lock;
+        Inner map;
+        char padding[64];
+    };
+
+    std::array<Shard, N> shards;
+
+    static std::size_t shard_index(key_type const& key) {
+        // std::hash is the identity for integers, so mix before reducing.
+        std::uint64_t const h = std::uint64_t(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+        return std::size_t(h >> 32) % N;
+    }
+
+    // Counting sort of the indices 0..count-1 by shard: shard i owns the
+    // indices second[first[i]] up to second[first[i + 1]].
+    template<typename KeyOf>
+    static std::pair<std::array<std::size_t, N + 1>, std::vector<std::size_t>> group_by_shard(std::size_t count, KeyOf key_of) {
+        std::vector<std::size_t> shard_of(count);
+        std::array<std::size_t, N + 1> bounds{};
+        for (std::size_t k = 0; k < count; ++k) {
+            shard_of[k] = shard_index(key_of(k));
+            ++bounds[shard_of[k] + 1];
+        }
+        for (std::size_t i = 0; i < N; ++i)
+            bounds[i + 1] += bounds[i];
+        std::vector<std::size_t> order(count);
+        auto next = bounds;
+        for (std::size_t k = 0; k < count; ++k)
+            order[next[shard_of[k]]++] = k;
+        return {bounds, std::move(order)};
+    }
+
+    Shard& shard_for(key_type const& key) {
+        return shards[shard_index(key)];
+    }
+
+    Shard const& shard_for(key_type const& key) const {
+        return shards[shard_index(key)];
+    }
+};
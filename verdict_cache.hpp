@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+// Puts a small per-thread cache of lookup verdicts in front of a map.  The
+// cache is 2-way set-associative with one 64 byte set per line; a way keeps
+// the key's 64 bit fingerprint, whether the key was found, the mapped value
+// the map generation it was filled at and the id of the map that filled it.
+// Every successful insert or erase bumps the generation, which turns all
+// older verdicts into misses without touching the caches of other threads.
+//
+// Keys are only compared by fingerprint, so two keys with the same 64 bit
+// hash share a verdict.  The sets are shared by all maps of one type on a
+// thread, but a way only hits for the map that filled it, so a thread that
+// alternates between maps keeps the verdicts of each.
+template<typename Inner, std::size_t Sets = 256, typename Hash = std::hash<typename Inner::key_type>>
+class CachedMap {
+public:
+    using key_type = typename Inner::key_type;
+    using mapped_type = typename Inner::mapped_type;
+    using value_type = typename Inner::value_type;
+    using size_type = std::size_t;
+    using lookup_type = std::pair<mapped_type, bool>;
+
+    static_assert(Sets > 0 && (Sets & (Sets - 1)) == 0, "CachedMap needs a power of two number of sets");
+
+    CachedMap() : id(next_id()++), generation(1) {}
+
+    CachedMap(CachedMap const& other) : id(next_id()++), generation(1), map(other.map) {}
+
+    CachedMap& operator=(CachedMap const& other) {
+        map = other.map;
+        bump_generation();
+        return *this;
+    }
+
+    bool insert(value_type const& value) {
+        bool const inserted = was_inserted(map.insert(value));
+        if (inserted)
+            bump_generation();
+        return inserted;
+    }
+
+    template<typename InIter>
+    void insert(InIter begin, InIter end) {
+        map.insert(begin, end);
+        bump_generation();
+    }
+
+    size_type erase(key_type const& key) {
+        size_type const erased = map.erase(key);
+        if (erased)
+            bump_generation();
+        return erased;
+    }
+
+    lookup_type find(key_type const& key) const {
+        Table& table = local_table();
+        if (table.owner != id)
+            table.switch_to(id);
+
+        std::uint64_t const fp = fingerprint(key);
+        Set& set = table.sets[(fp >> 32) & (Sets - 1)];
+        std::uint32_t const gen = generation.load(std::memory_order_acquire);
+        for (unsigned int w = 0; w < 2; ++w) {
+            Way& way = set.ways[w];
+            if (way.generation == gen && way.owner == id && way.fingerprint == fp) {
+                set.mru = (unsigned char)w;
+                ++table.hits;
+                return {way.value, way.found};
+            }
+        }
+
+        ++table.misses;
+        lookup_type const result = to_lookup(map.find(key));
+        Way& victim = set.ways[set.mru ^ 1];
+        victim.fingerprint = fp;
+        victim.owner = id;
+        victim.generation = gen;
+        victim.found = result.second;
+        victim.value = result.first;
+        set.mru ^= 1;
+        return result;
+    }
+
+    bool contains(key_type const& key) const {
+        return find(key).second;
+    }
+
+    size_type size() const {
+        return map.size();
+    }
+
+    bool empty() const {
+        return map.empty();
+    }
+
+    // Hits and misses of the calling thread since it last switched maps.
+    std::size_t cache_hits() const {
+        return local_table().owner == id ? local_table().hits : 0;
+    }
+
+    std::size_t cache_misses() const {
+        return local_table().owner == id ? local_table().misses : 0;
+    }
+
+private:
+    struct Way {
+        std::uint64_t fingerprint;
+        std::uint64_t owner = 0; //!< id of the map the verdict is for; ids start at 1.
+        std::uint32_t generation = 0; //!< Never 0 for a filled way.
+        bool found;
+        mapped_type value;
+    };
+
+    struct alignas(64) Set {
+        Way ways[2];
+        unsigned char mru; //!< Way that was used last; the other one is evicted.
+    };
+
+    // The counters are for the map the thread used last; switching maps
+    // only restarts them, the ways stay.
+    struct Table {
+        std::uint64_t owner = 0;
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::array<Set, Sets> sets;
+
+        void switch_to(std::uint64_t new_owner) {
+            owner = new_owner;
+            hits = misses = 0;
+        }
+    };
+
+    std::uint64_t const id;
+    std::atomic<std::uint32_t> generation;
+    Inner map;
+
+    // Wrapping to 0 would make filled ways look empty, so 0 is skipped.
+    void bump_generation() {
+        std::uint32_t gen = generation.load();
+        while (!generation.compare_exchange_weak(gen, gen + 1 == 0 ? 1 : gen + 1)) {
+        }
+    }
+
+    static std::atomic<std::uint64_t>& next_id() {
+        static std::atomic<std::uint64_t> counter{1};
+        return counter;
+    }
+
+    static Table& local_table() {
+        static thread_local Table table;
+        return table;
+    }
+
+    static std::uint64_t fingerprint(key_type const& key) {
+        // std::hash is the identity for integers, so mix all the bits.
+        std::uint64_t x = std::uint64_t(Hash()(key));
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // Maps that hand out lookup_type already, like ShardedMap.
+    static lookup_type to_lookup(lookup_type result) {
+        return result;
+    }
+
+    template<typename Iter>
+    lookup_type to_lookup(Iter it) const {
+        if (it == map.end())
+            return {mapped_type(), false};
+        return {it->second, true};
+    }
+
+    template<typename Iter>
+    static bool was_inserted(std::pair<Iter, bool> const& result) {
+        return result.second;
+    }
+
+    static bool was_inserted(bool inserted) {
+        return inserted;
+    }
+};